@@ -4078,6 +4078,7 @@ static void macros (Ast * n, Stack * stack, void * data)
 
     Ast * parameters = ast_child (n, sym_foreach_parameters);
     bool serial = false;
+    const char * schedule = NULL;
     char * sreductions = NULL;
     if (parameters) {
       foreach_item (parameters, 2, item) {
@@ -4086,6 +4087,12 @@ static void macros (Ast * n, Stack * stack, void * data)
 	  serial = true;
 	  parameters = ast_list_remove (parameters, item);
 	}
+	else if (identifier && (!strcmp (ast_terminal (identifier)->start, "dynamic") ||
+				!strcmp (ast_terminal (identifier)->start, "guided"))) {
+	  schedule = !strcmp (ast_terminal (identifier)->start, "dynamic") ?
+	    "dynamic" : "guided";
+	  parameters = ast_list_remove (parameters, item);
+	}
 	else if (identifier && (!strcmp (ast_terminal (identifier)->start, "cpu") ||
 				!strcmp (ast_terminal (identifier)->start, "gpu")))
 	  parameters = ast_list_remove (parameters, item);
@@ -4166,6 +4173,12 @@ static void macros (Ast * n, Stack * stack, void * data)
 		  "  #undef OMP\n"
 		  "  #define OMP(x)\n"
 		  "#endif\n");
+    else if (schedule)
+      ast_before (n, "\n"
+		  "#if _OPENMP\n"
+		  "  #undef OMP_FOR\n"
+		  "  #define OMP_FOR() OMP_SCHEDULE(", schedule, ", omp_chunk)\n"
+		  "#endif\n");
     if (sreductions) {
       ast_before (n, "\n"
 		  "#undef OMP_PARALLEL\n"
@@ -4187,6 +4200,12 @@ static void macros (Ast * n, Stack * stack, void * data)
 		 "  #undef OMP\n"
 		 "  #define OMP(x) _Pragma(#x)\n"
 		 "#endif\n");
+    else if (schedule)
+      ast_after (n, "\n"
+		 "#if _OPENMP\n"
+		 "  #undef OMP_FOR\n"
+		 "  #define OMP_FOR() OMP_STATIC()\n"
+		 "#endif\n");
     
     break;
   }
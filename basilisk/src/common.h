@@ -507,6 +507,9 @@ typedef struct {
 @if _MPI
   double min, max;
 @endif // _MPI
+@if _OPENMP
+  double wait;
+@endif // _OPENMP
 } TraceIndex;
 				      
 struct {
@@ -518,7 +521,7 @@ struct {
 };
 
 static void trace_add (const char * func, const char * file, int line,
-		       double total, double self)
+		       double total, double self, double wait)
 {
   TraceIndex * t = (TraceIndex *) Trace.index.p;
   int i, len = Trace.index.len/sizeof(TraceIndex);
@@ -527,20 +530,33 @@ static void trace_add (const char * func, const char * file, int line,
       break;
   if (i == len) {
     TraceIndex t = {strdup(func), strdup(file), line, 1, total, self};
+@if _OPENMP
+    t.wait = wait;
+@endif
     array_append (&Trace.index, &t, sizeof(TraceIndex));
   }
-  else
+  else {
     t->calls++, t->total += total, t->self += self;
+@if _OPENMP
+    t->wait += wait;
+@endif
+  }
 }
 
+/**
+The stack holds, for each active function, its start time, the total
+time of its callees and the time the threads spent waiting at the end
+of its OpenMP loops. */
+
+
 static void tracing (const char * func, const char * file, int line)
 {
   struct timeval tv;
   gettimeofday (&tv, NULL);
   if (Trace.t0 < 0)
     Trace.t0 = tv.tv_sec + tv.tv_usec/1e6;
-  double t[2] = {(tv.tv_sec - Trace.t0) + tv.tv_usec/1e6, 0.};
-  array_append (&Trace.stack, t, 2*sizeof(double));
+  double t[3] = {(tv.tv_sec - Trace.t0) + tv.tv_usec/1e6, 0., 0.};
+  array_append (&Trace.stack, t, 3*sizeof(double));
 #if 0
   fprintf (stderr, "trace %s:%s:%d t: %g sum: %g\n",
 	   func, file, line, t[0], t[1]);
@@ -553,21 +569,61 @@ static void end_tracing (const char * func, const char * file, int line)
   gettimeofday (&tv, NULL);
   double te = (tv.tv_sec - Trace.t0) + tv.tv_usec/1e6;
   double * t = (double *) Trace.stack.p;
-  assert (Trace.stack.len >= 2*sizeof(double));
-  t += Trace.stack.len/sizeof(double) - 2;
-  Trace.stack.len -= 2*sizeof(double);
+  assert (Trace.stack.len >= 3*sizeof(double));
+  t += Trace.stack.len/sizeof(double) - 3;
+  Trace.stack.len -= 3*sizeof(double);
   double dt = te - t[0];
 #if 0
   fprintf (stderr, "end trace %s:%s:%d ts: %g te: %g dt: %g sum: %g\n",
 	   func, file, line, t[0], te, dt, t[1]);
 #endif
-  trace_add (func, file, line, dt, dt - t[1]);
-  if (Trace.stack.len >= 2*sizeof(double)) {
-    t -= 2;
+  trace_add (func, file, line, dt, dt - t[1], t[2]);
+  if (Trace.stack.len >= 3*sizeof(double)) {
+    t -= 3;
     t[1] += dt;
   }
 }
 
+@if _OPENMP
+
+/**
+## Load imbalance of OpenMP loops
+
+Each thread records how long it took to complete its share of the
+iterations of a `foreach()` loop. The loop ends with a barrier: the
+average time the threads wait there (the slowest thread minus the
+mean) is charged to the innermost traced function. */
+
+@define TRACE_THREADS 256
+static double trace_busy[TRACE_THREADS];
+
+static void trace_loop_wait (void)
+{
+  int n = min (omp_get_num_threads(), TRACE_THREADS);
+  double tmax = 0., sum = 0.;
+  for (int i = 0; i < n; i++) {
+    sum += trace_busy[i];
+    if (trace_busy[i] > tmax)
+      tmax = trace_busy[i];
+  }
+  if (Trace.stack.len >= 3*sizeof(double)) {
+    double * t = (double *) Trace.stack.p;
+    t[Trace.stack.len/sizeof(double) - 1] += tmax - sum/n;
+  }
+}
+
+@define TRACE_LOOPS 1
+@define OMP_LOOP_START() double _loop_start = omp_get_wtime()
+@def OMP_LOOP_END()
+  if (tid() < TRACE_THREADS)
+    trace_busy[tid()] = omp_get_wtime() - _loop_start;
+  OMP(omp barrier)
+  OMP(omp master)
+  trace_loop_wait();
+@
+
+@endif // _OPENMP
+
 static int compar_self (const void * p1, const void * p2)
 {
   const TraceIndex * t1 = p1, * t2 = p2;
@@ -616,13 +672,20 @@ void trace_print (FILE * fp, double threshold)
 	       t->calls, t->total, t->self, t->self*100./total);
 @if _MPI
       fprintf (fp, " (%4.1f%% - %4.1f%%)", t->min*100./total, t->max*100./total);
+@endif
+@if _OPENMP
+      fprintf (fp, " (wait %4.1f%%)", t->self > 0. ? t->wait*100./t->self : 0.);
 @endif
       fprintf (fp, "   %s():%s:%d\n", t->func, t->file, t->line);
     }
   fflush (fp);
   array_free (index);
-  for (i = 0, t = (TraceIndex *) Trace.index.p; i < len; i++, t++)
+  for (i = 0, t = (TraceIndex *) Trace.index.p; i < len; i++, t++) {
     t->calls = t->total = t->self = 0.;
+@if _OPENMP
+    t->wait = 0.;
+@endif
+  }
 }
 
 static void trace_off()
@@ -808,6 +871,26 @@ void mpi_init()
 
 @define OMP_PARALLEL() OMP(omp parallel)
 
+/**
+The iterations of `foreach()` loops are shared statically between
+the OpenMP threads. The `dynamic` and `guided` loop attributes, as in
+`foreach (dynamic)`, select the corresponding schedule, with chunks of
+*omp_chunk* cells, for loops whose cost per cell varies a lot. With
+built-in tracing (`-DTRACE=2`), the loops end with an explicit barrier
+so that the time the threads wait there can be measured. */
+
+@if TRACE_LOOPS
+@ define OMP_STATIC() OMP(omp for schedule(static) nowait)
+@ define OMP_SCHEDULE(kind,chunk) OMP(omp for schedule(kind,chunk) nowait)
+@else
+@ define OMP_STATIC() OMP(omp for schedule(static))
+@ define OMP_SCHEDULE(kind,chunk) OMP(omp for schedule(kind,chunk))
+@ define OMP_LOOP_START()
+@ define OMP_LOOP_END()
+@endif
+@define OMP_FOR() OMP_STATIC()
+int omp_chunk = 64;
+
 @define NOT_UNUSED(x) (void)(x)
 
 @define VARIABLES      _CATCH;
@@ -983,6 +1066,7 @@ typedef struct {
   vector v;
   int face;
   bool   nodump, freed;
+  bool   single; // single precision is enough (MPI halos and sectioned dumps)
   int    block;
   scalar * depends; // boundary conditions depend on other fields
 } _Attributes;
@@ -1188,12 +1272,14 @@ struct _Event {
   int i, a;
   void * data;
   Event * next;
+  bool lazy;
 };
 
 static Event * Events = NULL; // all events
 
 int iter = 0, inext = 0; // current step and step of next event
 double t = 0, tnext = 0; // current time and time of next event
+double tevent = 0; // scheduled time of the current event
 void init_events (void);
 void event_register (Event event);
 static void _init_solver (void);
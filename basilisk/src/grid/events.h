@@ -135,17 +135,64 @@ below to control (i.e. shorten) the events loop. */
 
 static bool overload_event() { return true; }
 
+/**
+## Lazy events
+
+By default, the timestep is shortened (see *dtnext()* below) so that
+the simulation lands exactly on the times of time-based events. For
+output events with a small period, this can add many short steps.
+
+After *event_lazy ("name")*, the time-based event *name* does not
+constrain the timestep anymore: it fires on the first step reached at
+or past its scheduled time. Within the event, *t* is the actual time
+and *tevent* the time at which the event was scheduled. If several
+occurrences fall within a single step, the event fires only once, for
+the last of them. */
+
+void event_lazy (const char * name, bool lazy = true)
+{
+  bool found = false;
+  for (Event * ev = Events; !ev->last; ev++)
+    if (!strcmp (ev->name, name)) {
+      for (Event * e = ev; e; e = e->next)
+	e->lazy = lazy;
+      found = true;
+    }
+  if (!found) {
+    fprintf (stderr, "event_lazy(): error: no event named '%s'\n", name);
+    exit (1);
+  }
+}
+
+static bool event_is_lazy (Event * ev)
+{
+  return ev->lazy && ev->t != - TEND_EVENT && !ev->arrayi;
+}
+
 static int event_do (Event * ev, bool action)
 {
-  if ((iter > ev->i && t > ev->t) || !event_cond (ev, iter, t))
+  bool lazy = event_is_lazy (ev);
+  if ((!lazy && iter > ev->i && t > ev->t) ||
+      !event_cond (ev, iter, lazy ? ev->t : t))
     return event_finished (ev);
-  if (!overload_event() || iter == ev->i || fabs (t - ev->t) <= TEPS*t) {
+  if (!overload_event() || iter == ev->i || fabs (t - ev->t) <= TEPS*t ||
+      (lazy && t > ev->t)) {
+    if (lazy && INC && !ev->arrayt) {
+      // skip to the last occurrence already passed
+      int i1 = ev->i; double t1 = ev->t;
+      (* INC) (&i1, &t1, ev);
+      while (t1 <= t + TEPS*t && event_cond (ev, iter, t1)) {
+	ev->t = t1;
+	(* INC) (&i1, &t1, ev);
+      }
+    }
     if (action) {
       bool finished = false;
       for (Event * e = ev; e; e = e->next) {
 #if DEBUG_EVENTS
 	event_print (e, stderr);
 #endif
+	tevent = lazy ? ev->t : t;
 	if ((* e->action) (iter, t, e))
 	  finished = true;
       }
@@ -205,7 +252,7 @@ int events (bool action)
     for (Event * ev = Events; !ev->last; ev++)    
       init_event (ev);
 
-  int cond = 0, cond1 = 0;
+  int cond = 0, cond1 = 0, lazy = 0;
   inext = END_EVENT; tnext = HUGE;
   for (Event * ev = Events; !ev->last && !cond; ev++)
     if (ev->i != END_EVENT && 
@@ -220,12 +267,15 @@ int events (bool action)
     if (status == event_alive && ev->i != END_EVENT &&
 	(COND || (INIT && !COND && !INC) || ev->arrayi || ev->arrayt))
       cond1 = 1;
-    if (ev->t > t && ev->t < tnext)
+    if (ev->t > t && ev->t < tnext && !event_is_lazy (ev))
       tnext = ev->t;
+    if (status == event_alive && event_is_lazy (ev) && ev->t > t)
+      lazy = 1;
     if (ev->i > iter && ev->i < inext)
       inext = ev->i;
   }
-  if (overload_event() && (!cond || cond1) && (tnext != HUGE || inext != END_EVENT)) {
+  if (overload_event() && (!cond || cond1) &&
+      (tnext != HUGE || inext != END_EVENT || lazy)) {
     inext = iter + 1;
     return 1;
   }
@@ -1,48 +1,171 @@
 #define MULTIGRID_MPI 1
 
+/**
+## Halo exchange
+
+The ghost layers of each level are exchanged with the (up to) $3^d-1$
+neighbours of the Cartesian topology (faces, edges and corners) in a
+single step: all the receives and sends are posted at once, so that the
+messages along the different directions overlap instead of being
+serialised dimension by dimension.
+
+The corner and edge ghost cells are received directly from the
+diagonal neighbours. Along directions without a neighbour (i.e. true
+domain boundaries), the transverse extent of the exchanged regions
+includes the ghost layers, as for the exchange dimension by
+dimension.
+
+The neighbours, the exchanged regions (for the last level) and the
+buffers are kept from one call to the next. The buffers only grow. */
+
+#define MPI_NDIRS 27
+
+typedef struct {
+  int d[3];              // direction (-1, 0 or 1 along each dimension)
+  int rank;              // neighbour in this direction
+  int level;             // level of the regions below (-1 if unset)
+  int lo[3], hi[3];      // cells sent (or received) in this direction
+  size_t size, capacity;
+  double * buf;
+} MpiDirection;
+
 typedef struct {
   Boundary b;
   MPI_Comm cartcomm;
+  int ndir;                                    // number of neighbours
+  MpiDirection rcv[MPI_NDIRS], snd[MPI_NDIRS]; // for each neighbour
 } MpiBoundary;
 
-foreach_dimension()
-static void * snd_x (int i, int dst, int tag, int level, scalar * list,
-		     MPI_Request * req)
+static int mpi_direction_index (const int * d)
 {
-  if (dst == MPI_PROC_NULL)
-    return NULL;
-  size_t size = 0;
-  for (scalar s in list)
-    size += s.block;
-  size *= pow((1 << level) + 2*GHOSTS, dimension - 1)*GHOSTS*sizeof(double);
-  double * buf = (double *) malloc (size), * b = buf;
-  foreach_slice_x (i, i + GHOSTS, level)
-    for (scalar s in list) {
-      memcpy (b, &s[], sizeof(double)*s.block);
-      b += s.block;
+  int k = 0;
+  for (int a = dimension - 1; a >= 0; a--)
+    k = 3*k + d[a] + 1;
+  return k;
+}
+
+static int mpi_neighbor_rank (MPI_Comm cartcomm, const int * d)
+{
+  int dims[dimension], periods[dimension], c[dimension];
+  MPI_Cart_get (cartcomm, dimension, dims, periods, c);
+  for (int a = 0; a < dimension; a++) {
+    c[a] += d[a];
+    if (c[a] < 0 || c[a] >= dims[a]) {
+      if (!periods[a])
+	return MPI_PROC_NULL;
+      c[a] = (c[a] + dims[a]) % dims[a];
     }
-  MPI_Isend (buf, size, MPI_BYTE, dst, tag, MPI_COMM_WORLD, req);
-  return buf;
+  }
+  int rank;
+  MPI_Cart_rank (cartcomm, c, &rank);
+  return rank;
 }
 
-foreach_dimension()
-static void rcv_x (int i, int src, int tag, int level, scalar * list)
+/**
+The regions sent (*recv = false*) or received (*recv = true*) in
+direction *d*. */
+
+static void mpi_direction_region (MpiDirection * m, MPI_Comm cartcomm,
+				  int level, bool recv)
+{
+  int npl = (1 << level) + 2*GHOSTS;
+  for (int a = 0; a < 3; a++)
+    m->lo[a] = 0, m->hi[a] = 1;
+  for (int a = 0; a < dimension; a++)
+    if (m->d[a] < 0)
+      m->lo[a] = recv ? 0 : GHOSTS,
+	m->hi[a] = recv ? GHOSTS : 2*GHOSTS;
+    else if (m->d[a] > 0)
+      m->lo[a] = recv ? npl - GHOSTS : npl - 2*GHOSTS,
+	m->hi[a] = recv ? npl : npl - GHOSTS;
+    else {
+      int e[3] = {0, 0, 0};
+      e[a] = -1;
+      m->lo[a] = mpi_neighbor_rank (cartcomm, e) != MPI_PROC_NULL ? GHOSTS : 0;
+      e[a] = 1;
+      m->hi[a] = mpi_neighbor_rank (cartcomm, e) != MPI_PROC_NULL ?
+	npl - GHOSTS : npl;
+    }
+}
+
+static void mpi_direction_copy (MpiDirection * m, scalar * list,
+				int l, bool unpack)
+{
+  Point point = {0};
+  point.level = l; point.n = 1 << point.level;
+  double * b = m->buf;
+  for (point.i = m->lo[0]; point.i < m->hi[0]; point.i++)
+#if dimension > 1
+    for (point.j = m->lo[1]; point.j < m->hi[1]; point.j++)
+#endif
+#if dimension > 2
+      for (point.k = m->lo[2]; point.k < m->hi[2]; point.k++)
+#endif
+	for (scalar s in list) {
+	  if (unpack)
+	    memcpy (&s[], b, sizeof(double)*s.block);
+	  else
+	    memcpy (b, &s[], sizeof(double)*s.block);
+	  b += s.block;
+	}
+}
+
+static size_t mpi_direction_size (MpiDirection * m, scalar * list)
 {
-  if (src == MPI_PROC_NULL)
-    return;
   size_t size = 0;
   for (scalar s in list)
     size += s.block;
-  size *= pow((1 << level) + 2*GHOSTS, dimension - 1)*GHOSTS*sizeof(double);
-  double * buf = (double *) malloc (size), * b = buf;
-  MPI_Status s;
-  MPI_Recv (buf, size, MPI_BYTE, src, tag, MPI_COMM_WORLD, &s);
-  foreach_slice_x (i, i + GHOSTS, level)
-    for (scalar s in list) {
-      memcpy (&s[], b, sizeof(double)*s.block);
-      b += s.block;      
-    }
-  free (buf);
+  for (int a = 0; a < dimension; a++)
+    size *= m->hi[a] - m->lo[a];
+  return size*sizeof(double);
+}
+
+/**
+Sets the region and the buffer of *m* for *list* on *level*. */
+
+static void mpi_direction_setup (MpiDirection * m, MPI_Comm cartcomm,
+				 scalar * list, int level, bool recv)
+{
+  if (m->level != level) {
+    mpi_direction_region (m, cartcomm, level, recv);
+    m->level = level;
+  }
+  m->size = mpi_direction_size (m, list);
+  if (m->size > m->capacity) {
+    free (m->buf);
+    m->buf = malloc (m->size);
+    m->capacity = m->size;
+  }
+}
+
+static void mpi_directions_init (MpiBoundary * mpi)
+{
+  int d[3] = {0, 0, 0};
+  mpi->ndir = 0;
+  for (d[0] = -1; d[0] <= 1; d[0]++)
+#if dimension > 1
+    for (d[1] = -1; d[1] <= 1; d[1]++)
+#endif
+#if dimension > 2
+      for (d[2] = -1; d[2] <= 1; d[2]++)
+#endif
+	{
+	  if (!d[0] && !d[1] && !d[2])
+	    continue;
+	  int rank = mpi_neighbor_rank (mpi->cartcomm, d);
+	  if (rank == MPI_PROC_NULL)
+	    continue;
+	  MpiDirection * m[2] = {&mpi->rcv[mpi->ndir], &mpi->snd[mpi->ndir]};
+	  for (int j = 0; j < 2; j++) {
+	    for (int a = 0; a < 3; a++)
+	      m[j]->d[a] = d[a];
+	    m[j]->rank = rank;
+	    m[j]->level = -1;
+	    m[j]->size = m[j]->capacity = 0;
+	    m[j]->buf = NULL;
+	  }
+	  mpi->ndir++;
+	}
 }
 
 trace
@@ -59,23 +182,40 @@ static void mpi_boundary_level (const Boundary * b, scalar * list, int level)
   
   if (level < 0) level = depth();  
   MpiBoundary * mpi = (MpiBoundary *) b;
-  struct { int x, y, z; } dir = {0,1,2};
-  foreach_dimension() {
-    int left, right;
-    MPI_Cart_shift (mpi->cartcomm, dir.x, 1, &left, &right);  
-    MPI_Request reqs[2];
-    void * buf[2];
-    int npl = (1 << level) + 2*GHOSTS, nr = 0;
-    if ((buf[0] = snd_x (npl - 2*GHOSTS, right, 0, level, list1, &reqs[nr])))
-      nr++;
-    if ((buf[1] = snd_x (2, left,  1, level, list1, &reqs[nr])))
-      nr++;
-    rcv_x (0, left,  0, level, list1);
-    rcv_x (npl - GHOSTS,   right, 1, level, list1);
-    MPI_Status stats[nr];
-    MPI_Waitall (nr, reqs, stats);
-    free (buf[0]); free (buf[1]);
+
+  /**
+  We first post the receives, then pack and post the sends. A message
+  sent in direction *d* is tagged with the index of *d*, so that it is
+  received from the neighbour in direction *-d* with the same tag, even
+  when several directions lead to the same process (periodic
+  boundaries with few processes). */
+
+  MPI_Request rreqs[MPI_NDIRS], sreqs[MPI_NDIRS];
+  for (int n = 0; n < mpi->ndir; n++) {
+    MpiDirection * r = &mpi->rcv[n];
+    int md[3] = {- r->d[0], - r->d[1], - r->d[2]};
+    mpi_direction_setup (r, mpi->cartcomm, list1, level, true);
+    MPI_Irecv (r->buf, r->size, MPI_BYTE, r->rank, mpi_direction_index (md),
+	       MPI_COMM_WORLD, &rreqs[n]);
+  }
+  for (int n = 0; n < mpi->ndir; n++) {
+    MpiDirection * s = &mpi->snd[n];
+    mpi_direction_setup (s, mpi->cartcomm, list1, level, false);
+    mpi_direction_copy (s, list1, level, false);
+    MPI_Isend (s->buf, s->size, MPI_BYTE, s->rank, mpi_direction_index (s->d),
+	       MPI_COMM_WORLD, &sreqs[n]);
+  }
+
+  /**
+  The ghost cells are filled as the messages arrive. */
+
+  for (int n = 0; n < mpi->ndir; n++) {
+    int i;
+    MPI_Status stat;
+    MPI_Waitany (mpi->ndir, rreqs, &i, &stat);
+    mpi_direction_copy (&mpi->rcv[i], list1, level, true);
   }
+  MPI_Waitall (mpi->ndir, sreqs, MPI_STATUSES_IGNORE);
 
   free (list1);
 
@@ -85,6 +225,8 @@ static void mpi_boundary_level (const Boundary * b, scalar * list, int level)
 static void mpi_boundary_destroy (Boundary * b)
 {
   MpiBoundary * m = (MpiBoundary *) b;
+  for (int n = 0; n < m->ndir; n++)
+    free (m->rcv[n].buf), free (m->snd[n].buf);
   MPI_Comm_free (&m->cartcomm);
   free (m);
 }
@@ -96,6 +238,7 @@ Boundary * mpi_boundary_new()
   MPI_Cart_create (MPI_COMM_WORLD, dimension,
 		   mpi_dims, &Period.x, 0, &m->cartcomm);
   MPI_Cart_coords (m->cartcomm, pid(), dimension, mpi_coords);
+  mpi_directions_init (m);
 
   // make sure other boundary conditions are not applied
   struct { int x, y, z; } dir = {0,1,2};
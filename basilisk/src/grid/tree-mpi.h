@@ -3,6 +3,20 @@ int debug_iteration = -1;
 
 void debug_mpi (FILE * fp1);
 
+/*
+  A buffer of the shared memory segment of a PE, holding the ghost
+  values it sends to another PE of the same node (see
+  halo_shared_update() below). The buffer is free when *ack* == *seq*.
+*/
+
+typedef struct {
+  long seq, ack;   // messages written by the sender/read by the receiver
+  int pid;         // the rank of the receiver
+  size_t size;     // the size of the message
+  size_t capacity; // the size of the buffer
+  size_t offset;   // the offset of the buffer in the segment
+} HaloSlot;
+
 typedef struct {
   CacheLevel * halo; // ghost cell indices for each level
   void * buf;        // MPI buffer
@@ -10,6 +24,8 @@ typedef struct {
   int depth;         // the maximum number of levels
   int pid;           // the rank of the PE  
   int maxdepth;      // the maximum depth for this PE (= depth or depth + 1)
+  HaloSlot * slot;   // shared memory buffer (PEs of the same node)
+  char * shared;     // its data
 } Rcv;
 
 typedef struct {
@@ -99,6 +115,8 @@ static Rcv * rcv_pid_pointer (RcvPid * p, int pid)
     rcv->depth = rcv->maxdepth = 0;
     rcv->halo = qmalloc (1, CacheLevel);
     rcv->buf = NULL;
+    rcv->slot = NULL;
+    rcv->shared = NULL;
     cache_level_init (&rcv->halo[0]);
   }
   return &p->rcv[i];
@@ -158,50 +176,90 @@ static Boundary * mpi_boundary = NULL;
 
 void debug_mpi (FILE * fp1);
 
-static void apply_bc (Rcv * rcv, scalar * list, scalar * listv,
-		      vector * listf, int l, MPI_Status s)
+/*
+  The buffers are packed bytewise: cell-centered fields with the
+  *single* attribute are exchanged in single precision, all the other
+  values in double precision.
+*/
+
+static size_t halo_size (scalar s)
 {
-  double * b = rcv->buf;
-  foreach_cache_level(rcv->halo[l], l) {
-    for (scalar s in list) {
-      memcpy (&s[], b, sizeof(double)*s.block);
-      b += s.block;
+  return s.block*(s.single ? sizeof(float) : sizeof(double));
+}
+
+static char * halo_pack (char * b, const double * v, scalar s)
+{
+  if (s.single)
+    for (int i = 0; i < s.block; i++, b += sizeof(float)) {
+      float f = v[i];
+      memcpy (b, &f, sizeof(float));
     }
+  else {
+    memcpy (b, v, sizeof(double)*s.block);
+    b += sizeof(double)*s.block;
+  }
+  return b;
+}
+
+static char * halo_unpack (char * b, double * v, scalar s)
+{
+  if (s.single)
+    for (int i = 0; i < s.block; i++, b += sizeof(float)) {
+      float f;
+      memcpy (&f, b, sizeof(float));
+      v[i] = f == (float) nodata ? nodata : f;
+    }
+  else {
+    memcpy (v, b, sizeof(double)*s.block);
+    b += sizeof(double)*s.block;
+  }
+  return b;
+}
+
+static bool halo_nodata (const char * b)
+{
+  double v;
+  memcpy (&v, b, sizeof(double));
+  return v == nodata;
+}
+
+static void apply_bc (Rcv * rcv, char * buf, size_t rlen,
+		      scalar * list, scalar * listv, vector * listf, int l)
+{
+  char * b = buf;
+  foreach_cache_level(rcv->halo[l], l) {
+    for (scalar s in list)
+      b = halo_unpack (b, &s[], s);
     for (vector v in listf)
       foreach_dimension() {
 	memcpy (&v.x[], b, sizeof(double)*v.x.block);
-	b += v.x.block;
-	if (*b != nodata && allocated(1))
+	b += sizeof(double)*v.x.block;
+	if (!halo_nodata (b) && allocated(1))
 	  memcpy (&v.x[1], b, sizeof(double)*v.x.block);
-	b += v.x.block;
+	b += sizeof(double)*v.x.block;
       }
     for (scalar s in listv) {
       for (int i = 0; i <= 1; i++)
 	for (int j = 0; j <= 1; j++)
 #if dimension == 3
 	  for (int k = 0; k <= 1; k++) {
-	    if (*b != nodata && allocated(i,j,k))
+	    if (!halo_nodata (b) && allocated(i,j,k))
 	      memcpy (&s[i,j,k], b, sizeof(double)*s.block);
-	    b += s.block;
+	    b += sizeof(double)*s.block;
 	  }
 #else // dimension == 2
           {
-	    if (*b != nodata && allocated(i,j))
+	    if (!halo_nodata (b) && allocated(i,j))
 	      memcpy (&s[i,j], b, sizeof(double)*s.block);
-	    b += s.block;	    
+	    b += sizeof(double)*s.block;
           }
 #endif // dimension == 2
     }
   }
-  size_t size = b - (double *) rcv->buf;
-  free (rcv->buf);
-  rcv->buf = NULL;
-
-  int rlen;
-  MPI_Get_count (&s, MPI_DOUBLE, &rlen);
+  size_t size = b - buf;
   if (rlen != size) {
     fprintf (stderr,
-	     "rlen (%d) != size (%ld), %d receiving from %d at level %d\n"
+	     "rlen (%ld) != size (%ld), %d receiving from %d at level %d\n"
 	     "Calling debug_mpi(NULL)...\n"
 	     "Aborting...\n",
 	     rlen, size, pid(), rcv->pid, l);
@@ -211,6 +269,16 @@ static void apply_bc (Rcv * rcv, scalar * list, scalar * listv,
   }
 }
 
+static void apply_bc_mpi (Rcv * rcv, scalar * list, scalar * listv,
+			  vector * listf, int l, MPI_Status s)
+{
+  int rlen;
+  MPI_Get_count (&s, MPI_BYTE, &rlen);
+  apply_bc (rcv, rcv->buf, rlen, list, listv, listf, l);
+  free (rcv->buf);
+  rcv->buf = NULL;
+}
+
 #ifdef TIMEOUT
 static struct {
   int count, source, tag;
@@ -301,6 +369,13 @@ static int list_lenb (scalar * list) {
   return len;
 }
 
+static size_t list_sizeb (scalar * list) {
+  size_t size = 0;
+  for (scalar s in list)
+    size += halo_size (s);
+  return size;
+}
+
 static int vectors_lenb (vector * list) {
   int len = 0;
   for (vector v in list)
@@ -308,6 +383,66 @@ static int vectors_lenb (vector * list) {
   return len;
 }
 
+/*
+  Ghost values exchanged with the PEs of the same node go through
+  shared memory (MPI-3 windows) rather than MPI messages. Each PE owns
+  a segment holding one buffer (*HaloSlot*) for each of the PEs of the
+  node it sends to. The sender packs the ghost values directly into the
+  buffer and the receiver unpacks them directly from it, which saves
+  the copies and the matching of the MPI stack. The buffers are sized
+  for *mpi_shared_values* values per ghost cell: larger messages (and
+  messages to other nodes) are sent with MPI. Setting
+  *mpi_shared_values* to zero (on all PEs, before the grid is
+  initialised, within `#if _MPI`) disables shared memory.
+*/
+
+int mpi_shared_values = 32;
+
+static struct {
+  MPI_Comm node;   // the PEs of this node
+  int * rank;      // the rank in node of each PE (or MPI_UNDEFINED)
+  MPI_Win win;     // the segments
+  bool init, win_allocated;
+} halo_shm;
+
+static void halo_shared_free()
+{
+  if (halo_shm.win_allocated) {
+    MPI_Win_unlock_all (halo_shm.win);
+    MPI_Win_free (&halo_shm.win);
+    halo_shm.win_allocated = false;
+  }
+}
+
+static bool halo_shared (Rcv * rcv, size_t size)
+{
+  return rcv->slot && size <= rcv->slot->capacity;
+}
+
+/* waiting on a shared buffer must not prevent the progress of the
+   pending MPI communications of this PE */
+static void halo_shared_progress()
+{
+  int flag;
+  MPI_Iprobe (MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &flag,
+	      MPI_STATUS_IGNORE);
+  MPI_Win_sync (halo_shm.win);
+}
+
+static bool halo_shared_ready (Rcv * rcv)
+{
+  return __atomic_load_n (&rcv->slot->seq, __ATOMIC_ACQUIRE) !=
+    rcv->slot->ack;
+}
+
+static void halo_shared_receive (Rcv * rcv, scalar * list, scalar * listv,
+				 vector * listf, int l)
+{
+  HaloSlot * slot = rcv->slot;
+  apply_bc (rcv, rcv->shared, slot->size, list, listv, listf, l);
+  __atomic_store_n (&slot->ack, slot->seq, __ATOMIC_RELEASE);
+}
+
 static void rcv_pid_receive (RcvPid * m, scalar * list, scalar * listv,
 			     vector * listf, int l)
 {
@@ -316,35 +451,51 @@ static void rcv_pid_receive (RcvPid * m, scalar * list, scalar * listv,
   
   prof_start ("rcv_pid_receive");
 
-  int len = list_lenb (list) + 2*dimension*vectors_lenb (listf) +
-    (1 << dimension)*list_lenb (listv);
+  size_t len = list_sizeb (list) + sizeof(double)*
+    (2*dimension*vectors_lenb (listf) + (1 << dimension)*list_lenb (listv));
 
   MPI_Request r[m->npid];
   Rcv * rrcv[m->npid]; // fixme: using NULL requests should be OK
-  int nr = 0;
+  Rcv * srcv[m->npid];
+  int nr = 0, ns = 0;
   for (int i = 0; i < m->npid; i++) {
     Rcv * rcv = &m->rcv[i];
     if (l <= rcv->depth && rcv->halo[l].n > 0) {
+      if (halo_shared (rcv, rcv->halo[l].n*len)) {
+	srcv[ns++] = rcv;
+	continue;
+      }
       assert (!rcv->buf);
-      rcv->buf = malloc (sizeof (double)*rcv->halo[l].n*len);
+      rcv->buf = malloc (rcv->halo[l].n*len);
 #if 0
-      fprintf (stderr, "%s receiving %d doubles from %d level %d\n",
+      fprintf (stderr, "%s receiving %ld bytes from %d level %d\n",
 	       m->name, rcv->halo[l].n*len, rcv->pid, l);
       fflush (stderr);
 #endif
 #if 1 /* initiate non-blocking receive */
-      MPI_Irecv (rcv->buf, rcv->halo[l].n*len, MPI_DOUBLE, rcv->pid,
+      MPI_Irecv (rcv->buf, rcv->halo[l].n*len, MPI_BYTE, rcv->pid,
 		 BOUNDARY_TAG(l), MPI_COMM_WORLD, &r[nr]);
       rrcv[nr++] = rcv;
 #else /* blocking receive (useful for debugging) */
       MPI_Status s;
-      mpi_recv_check (rcv->buf, rcv->halo[l].n*len, MPI_DOUBLE, rcv->pid,
+      mpi_recv_check (rcv->buf, rcv->halo[l].n*len, MPI_BYTE, rcv->pid,
 		      BOUNDARY_TAG(l), MPI_COMM_WORLD, &s, "rcv_pid_receive");
-      apply_bc (rcv, list, listf, listv, l, s);
+      apply_bc_mpi (rcv, list, listv, listf, l, s);
 #endif
     }
   }
 
+  /* shared memory receives, in the order in which they complete */
+  while (ns > 0) {
+    for (int i = 0; i < ns; i++)
+      if (halo_shared_ready (srcv[i])) {
+	halo_shared_receive (srcv[i], list, listv, listf, l);
+	srcv[i--] = srcv[--ns];
+      }
+    if (ns > 0)
+      halo_shared_progress();
+  }
+  
   /* non-blocking receives (does nothing when using blocking receives) */
   if (nr > 0) {
     int i;
@@ -354,7 +505,7 @@ static void rcv_pid_receive (RcvPid * m, scalar * list, scalar * listv,
       Rcv * rcv = rrcv[i];
       assert (l <= rcv->depth && rcv->halo[l].n > 0);
       assert (rcv->buf);
-      apply_bc (rcv, list, listv, listf, l, s);
+      apply_bc_mpi (rcv, list, listv, listf, l, s);
       mpi_waitany (nr, r, &i, &s);
     }
   }
@@ -370,6 +521,48 @@ static void rcv_pid_wait (RcvPid * m)
     rcv_free_buf (&m->rcv[i]);
 }
 
+static char * halo_pack_level (Rcv * rcv, char * b, scalar * list,
+			       scalar * listv, vector * listf, int l)
+{
+  const double nodata_value = nodata;
+  foreach_cache_level(rcv->halo[l], l) {
+    for (scalar s in list)
+      b = halo_pack (b, &s[], s);
+    for (vector v in listf)
+      foreach_dimension() {
+	memcpy (b, &v.x[], sizeof(double)*v.x.block);
+	b += sizeof(double)*v.x.block;
+	if (allocated(1))
+	  memcpy (b, &v.x[1], sizeof(double)*v.x.block);
+	else
+	  memcpy (b, &nodata_value, sizeof(double));
+	b += sizeof(double)*v.x.block;
+      }
+    for (scalar s in listv) {
+      for (int i = 0; i <= 1; i++)
+	for (int j = 0; j <= 1; j++)
+#if dimension == 3
+	  for (int k = 0; k <= 1; k++) {
+	    if (allocated(i,j,k))
+	      memcpy (b, &s[i,j,k], sizeof(double)*s.block);
+	    else
+	      memcpy (b, &nodata_value, sizeof(double));
+	    b += sizeof(double)*s.block;
+	  }
+#else // dimension == 2
+	  {
+	    if (allocated(i,j))
+	      memcpy (b, &s[i,j], sizeof(double)*s.block);
+	    else
+	      memcpy (b, &nodata_value, sizeof(double));
+	    b += sizeof(double)*s.block;
+	  }
+#endif // dimension == 2
+    }
+  }
+  return b;
+}
+
 static void rcv_pid_send (RcvPid * m, scalar * list, scalar * listv,
 			  vector * listf, int l)
 {
@@ -378,60 +571,33 @@ static void rcv_pid_send (RcvPid * m, scalar * list, scalar * listv,
 
   prof_start ("rcv_pid_send");
 
-  int len = list_lenb (list) + 2*dimension*vectors_lenb (listf) +
-    (1 << dimension)*list_lenb (listv);
+  size_t len = list_sizeb (list) + sizeof(double)*
+    (2*dimension*vectors_lenb (listf) + (1 << dimension)*list_lenb (listv));
 
   /* send ghost values */
   for (int i = 0; i < m->npid; i++) {
     Rcv * rcv = &m->rcv[i];
     if (l <= rcv->depth && rcv->halo[l].n > 0) {
-      assert (!rcv->buf);
-      rcv->buf = malloc (sizeof (double)*rcv->halo[l].n*len);
-      double * b = rcv->buf;
-      foreach_cache_level(rcv->halo[l], l) {
-	for (scalar s in list) {
-	  memcpy (b, &s[], sizeof(double)*s.block);
-	  b += s.block;
-	}
-	for (vector v in listf)
-	  foreach_dimension() {
-	    memcpy (b, &v.x[], sizeof(double)*v.x.block);
-	    b += v.x.block;
-	    if (allocated(1))
-	      memcpy (b, &v.x[1], sizeof(double)*v.x.block);
-	    else
-	      *b = nodata;
-	    b += v.x.block;
-	  }
-	for (scalar s in listv) {
-	  for (int i = 0; i <= 1; i++)
-	    for (int j = 0; j <= 1; j++)
-#if dimension == 3
-	      for (int k = 0; k <= 1; k++) {
-		if (allocated(i,j,k))
-		  memcpy (b, &s[i,j,k], sizeof(double)*s.block);
-		else
-		  *b = nodata;
-		b += s.block;
-	      }
-#else // dimension == 2
-	      {
-		if (allocated(i,j))
-		  memcpy (b, &s[i,j], sizeof(double)*s.block);
-		else
-		  *b = nodata;
-		b += s.block;
-	      }
-#endif // dimension == 2
-	}
+      if (halo_shared (rcv, rcv->halo[l].n*len)) {
+	/* wait until the receiver has read the previous message */
+	HaloSlot * slot = rcv->slot;
+	while (__atomic_load_n (&slot->ack, __ATOMIC_ACQUIRE) != slot->seq)
+	  halo_shared_progress();
+	char * b = halo_pack_level (rcv, rcv->shared, list, listv, listf, l);
+	slot->size = b - rcv->shared;
+	__atomic_store_n (&slot->seq, slot->seq + 1, __ATOMIC_RELEASE);
+	continue;
       }
+      assert (!rcv->buf);
+      rcv->buf = malloc (rcv->halo[l].n*len);
+      char * b = halo_pack_level (rcv, rcv->buf, list, listv, listf, l);
 #if 0
-      fprintf (stderr, "%s sending %d doubles to %d level %d\n",
-	       m->name, rcv->halo[l].n*len, rcv->pid, l);
+      fprintf (stderr, "%s sending %ld bytes to %d level %d\n",
+	       m->name, b - (char *) rcv->buf, rcv->pid, l);
       fflush (stderr);
 #endif
-      MPI_Isend (rcv->buf, (b - (double *) rcv->buf),
-		 MPI_DOUBLE, rcv->pid, BOUNDARY_TAG(l), MPI_COMM_WORLD,
+      MPI_Isend (rcv->buf, (b - (char *) rcv->buf),
+		 MPI_BYTE, rcv->pid, BOUNDARY_TAG(l), MPI_COMM_WORLD,
 		 &rcv->r);
     }
   }
@@ -483,6 +649,12 @@ static void mpi_boundary_destroy (Boundary * b)
   snd_rcv_destroy (&m->mpi_level);
   snd_rcv_destroy (&m->mpi_level_root);
   snd_rcv_destroy (&m->restriction);
+  halo_shared_free();
+  if (halo_shm.init) {
+    MPI_Comm_free (&halo_shm.node);
+    free (halo_shm.rank);
+    halo_shm.init = false;
+  }
   array_free (m->send);
   array_free (m->receive);
   free (m);
@@ -854,6 +1026,116 @@ static bool has_local_child (Point point)
   return false;
 }
 
+static size_t halo_align (size_t size)
+{
+  return (size + 63) & ~((size_t) 63);
+}
+
+static HaloSlot * halo_slot (char * base, int pid)
+{
+  HaloSlot * slot = (HaloSlot *) (base + sizeof(long));
+  for (long j = 0; j < *((long *) base); j++, slot++)
+    if (slot->pid == pid)
+      return slot;
+  return NULL;
+}
+
+/*
+  The shared memory buffers are reallocated for the new ghost cells. The
+  PEs of the node are found from the communicator topology, at the first
+  call. All the PEs of a node must call this function.
+*/
+
+static void halo_shared_update (MpiBoundary * m)
+{
+  halo_shared_free();
+  if (!halo_shm.init) {
+    MPI_Comm_split_type (MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0,
+			 MPI_INFO_NULL, &halo_shm.node);
+    MPI_Group world, node;
+    MPI_Comm_group (MPI_COMM_WORLD, &world);
+    MPI_Comm_group (halo_shm.node, &node);
+    int ranks[npe()];
+    for (int i = 0; i < npe(); i++)
+      ranks[i] = i;
+    halo_shm.rank = malloc (npe()*sizeof(int));
+    MPI_Group_translate_ranks (world, npe(), ranks, node, halo_shm.rank);
+    MPI_Group_free (&world);
+    MPI_Group_free (&node);
+    halo_shm.init = true;
+  }
+  int nnode;
+  MPI_Comm_size (halo_shm.node, &nnode);
+  if (nnode == 1 || mpi_shared_values <= 0)
+    return;
+
+  /* the PEs of the node we send to, and their maximum number of ghost
+     cells per level */
+  SndRcv * sr[3] = {&m->mpi_level, &m->mpi_level_root, &m->restriction};
+  int pids[nnode], n = 0;
+  long ncells[nnode];
+  for (int k = 0; k < 3; k++)
+    for (int i = 0; i < sr[k]->snd->npid; i++) {
+      Rcv * rcv = &sr[k]->snd->rcv[i];
+      if (halo_shm.rank[rcv->pid] == MPI_UNDEFINED)
+	continue;
+      int j = 0;
+      while (j < n && pids[j] != rcv->pid)
+	j++;
+      if (j == n)
+	pids[n] = rcv->pid, ncells[n++] = 0;
+      for (int l = 0; l <= rcv->depth; l++)
+	if (rcv->halo[l].n > ncells[j])
+	  ncells[j] = rcv->halo[l].n;
+    }
+
+  size_t size = halo_align (sizeof(long) + n*sizeof(HaloSlot)), offset = size;
+  for (int j = 0; j < n; j++)
+    size += halo_align (ncells[j]*mpi_shared_values*sizeof(double));
+  MPI_Info info;
+  MPI_Info_create (&info);
+  MPI_Info_set (info, "alloc_shared_noncontig", "true");
+  char * base;
+  MPI_Win_allocate_shared (size, 1, info, halo_shm.node, &base, &halo_shm.win);
+  MPI_Info_free (&info);
+  MPI_Win_lock_all (MPI_MODE_NOCHECK, halo_shm.win);
+  halo_shm.win_allocated = true;
+
+  *((long *) base) = n;
+  HaloSlot * slot = (HaloSlot *) (base + sizeof(long));
+  for (int j = 0; j < n; j++) {
+    size_t capacity = halo_align (ncells[j]*mpi_shared_values*sizeof(double));
+    slot[j] = (HaloSlot){0, 0, pids[j], 0, capacity, offset};
+    offset += capacity;
+  }
+  MPI_Win_sync (halo_shm.win);
+  MPI_Barrier (halo_shm.node);
+  MPI_Win_sync (halo_shm.win);
+
+  /* the buffers of the senders are in their segments */
+  for (int k = 0; k < 3; k++) {
+    for (int i = 0; i < sr[k]->snd->npid; i++) {
+      Rcv * rcv = &sr[k]->snd->rcv[i];
+      if (halo_shm.rank[rcv->pid] != MPI_UNDEFINED) {
+	rcv->slot = halo_slot (base, rcv->pid);
+	rcv->shared = base + rcv->slot->offset;
+      }
+    }
+    for (int i = 0; i < sr[k]->rcv->npid; i++) {
+      Rcv * rcv = &sr[k]->rcv->rcv[i];
+      if (halo_shm.rank[rcv->pid] != MPI_UNDEFINED) {
+	MPI_Aint qsize;
+	int disp;
+	char * qbase;
+	MPI_Win_shared_query (halo_shm.win, halo_shm.rank[rcv->pid],
+			      &qsize, &disp, &qbase);
+	if ((rcv->slot = halo_slot (qbase, pid())))
+	  rcv->shared = qbase + rcv->slot->offset;
+      }
+    }
+  }
+}
+
 trace
 void mpi_boundary_update_buffers()
 {
@@ -996,6 +1278,8 @@ void mpi_boundary_update_buffers()
   rcv_pid_append_pids (mpi_level_root->snd, m->send);
   rcv_pid_append_pids (mpi_level->rcv, m->receive);
   rcv_pid_append_pids (mpi_level_root->rcv, m->receive);
+
+  halo_shared_update (m);
   
   prof_stop();
 
@@ -152,6 +152,7 @@ typedef struct {
   CacheLevel * restriction;
   
   bool dirty;       /* whether caches should be updated */
+  long generation;  /* number of cache updates */
 } Tree;
 
 #define tree ((Tree *)grid)
@@ -427,7 +428,8 @@ void cache_shrink (Cache * c)
   point.k = GHOSTS;
 #endif
   int _k; unsigned short _flags; NOT_UNUSED(_flags);
-  OMP(omp for schedule(static))
+  OMP_LOOP_START();
+  OMP_FOR()
   for (_k = 0; _k < _cache.n; _k++) {
     point.i = _cache.p[_k].i;
 #if dimension >= 2
@@ -440,7 +442,7 @@ void cache_shrink (Cache * c)
     _flags = _cache.p[_k].flags;
     POINT_VARIABLES;
 @
-@define end_foreach_cache() } } }
+@define end_foreach_cache() } OMP_LOOP_END(); } }
 
 @def foreach_cache_level(_cache,_l) {
   OMP_PARALLEL() {
@@ -455,7 +457,8 @@ void cache_shrink (Cache * c)
 #endif
   point.level = _l;
   int _k;
-  OMP(omp for schedule(static))
+  OMP_LOOP_START();
+  OMP_FOR()
   for (_k = 0; _k < _cache.n; _k++) {
     point.i = _cache.p[_k].i;
 #if dimension >= 2
@@ -466,7 +469,7 @@ void cache_shrink (Cache * c)
 #endif
     POINT_VARIABLES;
 @
-@define end_foreach_cache_level() } } }
+@define end_foreach_cache_level() } OMP_LOOP_END(); } }
 
 @def foreach_boundary_level(_l) {
   if (_l <= depth()) {
@@ -673,6 +676,7 @@ static void update_cache_f (void)
 }
   
   q->dirty = false;
+  q->generation++;
 
 #if FBOUNDARY
   for (int l = depth(); l >= 0; l--)
@@ -229,6 +229,12 @@ static void column_propagation (vector h)
 	  h.x[] = h.x[i] + i;
 }
 
+/**
+On trees, the columns can be restricted to a band around the
+interface, see [below](#interface-band). */
+
+bool heights_band = false;
+
 /**
 ## Multigrid implementation
 
@@ -351,6 +357,49 @@ static void refine_h_x (Point point, scalar h)
 #endif // dimension == 3
 }
 
+/**
+## Interface band
+
+A height is only defined if the 9-cells-high column contains a cell
+which is not full and a cell which is not empty. With *heights_band*,
+the columns are only integrated in a band around the interface, which
+is found on the next coarser level: *band* is set on the parents whose
+(restricted) volume fractions are not uniform within two cells along
+each direction. These two parent cells contain the four cells of each
+half-column. The other cells are set to *nodata*, as they would be by
+*half_column()*, so that the result is unchanged.
+
+This assumes that the prolongation of *c* preserves full and empty
+cells, as for VOF tracers. The cost of the integration is then
+proportional to the area of the interface rather than to the number
+of cells, which matters in 3D. */
+
+static inline bool band_parent (Point point, scalar c)
+{
+  double cmin = c[], cmax = c[];
+  for (int i = -2; i <= 2; i++)
+    foreach_dimension() {
+      if (c[i] < cmin) cmin = c[i];
+      if (c[i] > cmax) cmax = c[i];
+    }
+  return cmin < 1. && cmax > 0.;
+}
+
+/**
+The shifted field is also needed on the neighbours (within two cells)
+of the band, i.e. on the children of the neighbours of the band
+parents. */
+
+static inline bool band_shifted (Point point, scalar band)
+{
+  if (coarse(band))
+    return true;
+  foreach_dimension()
+    if (coarse(band,-1) || coarse(band,1))
+      return true;
+  return false;
+}
+
 /**
 The *heights()* function implementation is similar to the multigrid
 case, but the construction of the shifted volume fraction field *cs*
@@ -363,6 +412,7 @@ void heights (scalar c, vector h)
   foreach_dimension()
     for (int i = 0; i < nboundary; i++)
       s.x.boundary[i] = c.boundary[i];
+  scalar band[];
 
   /**
   To compute the shifted field, we first need to *restrict* the volume
@@ -381,12 +431,23 @@ void heights (scalar c, vector h)
   
     for (int l = 1; l <= depth(); l++) {
 
+      /**
+      The band is found on the coarser level, for both directions of
+      integration. */
+
+      if (heights_band && j == -1) {
+	foreach_level (l - 1)
+	  band[] = band_parent (point, c);
+	boundary_iterate (level, {band}, l - 1);
+      }
+
       /**
       We construct the ($\pm 2$) shifted field at this level. */
       
       foreach_level (l)
-	foreach_dimension()
-	  s.x[] = c[2*j];
+	if (!heights_band || band_shifted (point, band))
+	  foreach_dimension()
+	    s.x[] = c[2*j];
 
       /**
       We then need to apply boundary conditions on the shifted
@@ -417,7 +478,11 @@ void heights (scalar c, vector h)
       according to *j*. */
 
       foreach_level (l)
-        half_column (point, c, h, s, j);
+	if (!heights_band || coarse(band))
+	  half_column (point, c, h, s, j);
+	else if (j == -1)
+	  foreach_dimension()
+	    h.x[] = nodata;
     }
   }
     
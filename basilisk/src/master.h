@@ -5,12 +5,18 @@ This is used in combination with [slave.h]().
 
 The user interface is just `slave_start` which defines the starting
 time of the slave simulation and the interface of coupling functions:
-here only `slave_interpolate()`. */
+`slave_interpolate()` for single points and the batched functions
+`slave_points()`, `slave_get()` and `slave_put()` (see
+[slave.h](slave.h#batched-coupling-functions)). */
 
 double slave_start = 0.;
 
 extern double slave_interpolate (const char * name, double xp = 0, double yp = 0, double zp = 0,
 				 bool linear = false);
+extern int slave_points (const char * name, coord * p, int n);
+extern void slave_get (int set, const char ** fields, double * v,
+		       bool linear = false);
+extern void slave_put (int set, const char ** fields, double * v);
 
 /**
 ## Synchronization events */
@@ -72,6 +72,32 @@ for which inertia is negligible compared to viscosity. */
 mgstats mgp = {0}, mgpf = {0}, mgu = {0};
 bool stokes = false;
 
+/**
+The optional *fused_step* merges some of the bookkeeping sweeps of the
+timestep (see the [viscous term](#viscous-term) and the [approximate
+projection](#approximate-projection) below). Results are then only
+identical up to round-off errors. This assumes that the face velocity
+field is not modified after the projection and that the centered
+velocity is not used between the viscous term and the projection
+(this is not compatible with [double-projection.h]()). */
+
+bool fused_step = false;
+
+/**
+With *stokes* (as set by [momentum-conserving advection](conserving.h)),
+the predicted face velocity and its projection are never used. The
+optional *lean_step* (off by default) then frees the auxiliary
+pressure *pf*, merges the reset of the acceleration with the
+projection of the previous timestep and lets the last module adding
+to the acceleration build the face velocity field in the same sweep
+(see the [acceleration term](#acceleration-term) below). Results are
+then only identical up to the tolerance of the pressure solver.
+*stokes* must not be reset after the [defaults](#initial-conditions)
+event, and *pf* must not be used. */
+
+bool lean_step = false;
+static bool lean = false;
+
 /**
 ## Boundary conditions
 
@@ -178,6 +204,16 @@ event defaults (i = 0)
   foreach()
     foreach_dimension()
       dimensional (u.x[] == Delta/t);
+
+  /**
+  With *lean_step*, the auxiliary pressure is freed: its slot is then
+  reused by the temporary fields allocated during the timestep. *pf*
+  must then not be used by any other module or by the user code: it
+  would read one of these fields. */
+
+  lean = lean_step && stokes;
+  if (lean)
+    delete ({pf});
 }
 
 
@@ -221,8 +257,39 @@ timing of upcoming events. */
 
 event set_dtmax (i++,last) dtmax = DT;
 
+/**
+With *fused_step*, the minimum CFL timestep over the faces has already
+been computed at the end of the previous timestep, unless the mesh
+changed since then. */
+
+static double dtcfl = HUGE;
+static bool cfl_valid = false;
+#if TREE
+static long cfl_generation = -1;
+#endif
+
+static bool cfl_cached()
+{
+  if (!fused_step)
+    return cfl_valid = false;
+  int valid = cfl_valid;
+#if TREE
+  valid = valid && tree->generation == cfl_generation;
+#endif
+#if _MPI
+  mpi_all_reduce (valid, MPI_INT, MPI_MIN);
+#endif
+  cfl_valid = false;
+  return valid;
+}
+
 event stability (i++,last) {
-  dt = dtnext (stokes ? dtmax : timestep (uf, dtmax));
+  if (stokes)
+    dt = dtnext (dtmax);
+  else if (cfl_cached())
+    dt = dtnext (timestep_update (min (dtmax/CFL, dtcfl)));
+  else
+    dt = dtnext (timestep (uf, dtmax));
 }
 
 /**
@@ -316,6 +383,11 @@ field. */
 event advection_term (i++,last)
 {
   if (!stokes) {
+    if (lean) {
+      fprintf (ferr, "centered.h: error: stokes was reset after lean_step"
+	       " freed pf\n");
+      exit (1);
+    }
     prediction();
     mgpf = project (uf, pf, alpha, dt/2., mgpf.nrelax);
     advection ((scalar *){u}, uf, dt, (scalar *){g});
@@ -340,20 +412,36 @@ The viscous term is computed implicitly. We first add the pressure
 gradient and acceleration terms, as computed at time $t$, then call
 the implicit viscosity solver. We then remove the acceleration and
 pressure gradient terms as they will be replaced by their values at
-time $t+\Delta t$. */
+time $t+\Delta t$.
+
+With *fused_step*, this last sweep is skipped: the velocity field is
+left shifted by $\Delta t\mathbf{g}$ and the shift is removed on the
+fly by the acceleration and projection events below. */
+
+static bool ushift = false, areset = false;
 
 event viscous_term (i++,last)
 {
   if (constant(mu.x) != 0.) {
     correction (dt);
     mgu = viscosity (u, mu, rho, dt, mgu.nrelax);
-    correction (-dt);
+#if !EMBED
+    if (fused_step)
+      ushift = true;
+    else
+#endif
+      correction (-dt);
   }
 
   /**
-  We reset the acceleration field (if it is not a constant). */
-
-  if (!is_constant(a.x)) {
+  We reset the acceleration field (if it is not a constant). This
+  cannot be merged with the end of the previous timestep: the pressure
+  boundary conditions of the predicted projection still use the
+  acceleration of the previous timestep. Without the predicted
+  projection (*lean_step*), this is done by the projection, except
+  for the first timestep. */
+
+  if (!is_constant(a.x) && !areset) {
     face vector af = a;
     trash ({af});
     foreach_face()
@@ -378,9 +466,47 @@ The (provisionary) face velocity field at time $t+\Delta t$ is
 obtained by interpolation from the centered velocity field. The
 acceleration term is added. */
 
+foreach_dimension()
+static inline double face_velocity_x (Point point)
+{
+#if !EMBED
+  if (ushift)
+    return fm.x[]*(face_value (u.x, 0) - dt*face_value (g.x, 0) + dt*a.x[]);
+#endif
+  return fm.x[]*(face_value (u.x, 0) + dt*a.x[]);
+}
+
+/**
+With *lean_step*, the *acceleration* event of a module which is the
+last to add to $\mathbf{a}$ (i.e. the one run just before the event
+below) can compute *uf.x[] = face_velocity_x (point)* in the same sweep
+over faces as its own term, if *uf_fusable (_ev)* is true. It then sets
+*uf_built* and the sweep below is skipped. *uf_fused* counts the
+timesteps for which this happened. */
+
+static bool uf_built = false;
+long uf_fused = 0;
+
+bool uf_fusable (Event * ev)
+{
+  return lean && ev->next && !ev->next->next;
+}
+
 event acceleration (i++,last)
 {
+  if (uf_built) {
+    uf_built = false;
+    uf_fused++;
+    return 0;
+  }
   trash ({uf});
+#if !EMBED
+  if (ushift)
+    foreach_face()
+      uf.x[] = fm.x[]*(face_value (u.x, 0) - dt*face_value (g.x, 0) +
+		       dt*a.x[]);
+  else
+#endif
   foreach_face()
     uf.x[] = fm.x[]*(face_value (u.x, 0) + dt*a.x[]);
 }
@@ -416,17 +542,76 @@ void centered_gradient (scalar p, vector g)
 /**
 To get the pressure field at time $t + \Delta t$ we project the face
 velocity field (which will also be used for tracer advection at the
-next timestep). Then compute the centered gradient field *g*. */
+next timestep). Then compute the centered gradient field *g* and add
+it to the centered velocity field.
 
-event projection (i++,last)
+This is the same as calling *centered_gradient()* then *correction
+(dt)*, but with a single sweep over the cells. With *fused_step*, the
+minimum CFL timestep of the projected face velocity field is also
+computed in the sweep over faces and the velocity shift of the viscous
+term is removed. With *lean_step*, the acceleration is also reset. */
+
+foreach_dimension()
+static inline double face_timestep_x (Point point)
 {
-  mgp = project (uf, p, alpha, dt, mgp.nrelax);
-  centered_gradient (p, g);
+  if (uf.x[] == 0.)
+    return HUGE;
+  double dtf = Delta/fabs(uf.x[]);
+#if EMBED
+  dtf *= fm.x[];
+#else
+  dtf *= cm[];
+#endif
+  return dtf;
+}
 
-  /**
-  We add the gradient field *g* to the centered velocity field. */
+static void projection_correction (scalar p, vector g, double dt)
+{
+  face vector gf[];
+  double dtmin = HUGE;
+  areset = lean && !is_constant(a.x);
+  if (areset) {
+    face vector af = a;
+    foreach_face (reduction(min:dtmin)) {
+      gf.x[] = fm.x[]*af.x[] - alpha.x[]*(p[] - p[-1])/Delta;
+      af.x[] = 0.;
+      if (fused_step) {
+	double dtf = face_timestep_x (point);
+	if (dtf < dtmin) dtmin = dtf;
+      }
+    }
+  }
+  else
+    foreach_face (reduction(min:dtmin)) {
+      gf.x[] = fm.x[]*a.x[] - alpha.x[]*(p[] - p[-1])/Delta;
+      if (fused_step) {
+	double dtf = face_timestep_x (point);
+	if (dtf < dtmin) dtmin = dtf;
+      }
+    }
+
+  if (!ushift)
+    trash ({g});
+  foreach()
+    foreach_dimension() {
+      double gn = (gf.x[] + gf.x[1])/(fm.x[] + fm.x[1] + SEPS);
+      u.x[] += ushift ? dt*(gn - g.x[]) : dt*gn;
+      g.x[] = gn;
+    }
+  ushift = false;
 
-  correction (dt);
+  if (fused_step) {
+    dtcfl = dtmin, cfl_valid = true;
+#if TREE
+    cfl_generation = tree->generation;
+#endif
+  }
+}
+
+event projection (i++,last)
+{
+  mgp = project (uf, p, alpha, dt, mgp.nrelax);
+  projection_correction (p, g, dt);
 }
 
 /**
@@ -32,7 +32,8 @@ static void momentum_restriction (Point point, scalar u)
 
 /**
 We switch-off the default advection scheme of the [centered
-solver](centered.h). */
+solver](centered.h). Its unused prediction state can then be dropped
+with *lean_step*. */
 
 event defaults (i = 0)
 {
@@ -1112,10 +1112,23 @@ void dump (const char * file = "dump",
 }
 @endif // _MPI
 
+/**
+## *restore()*
+
+The arguments are the same as for *dump()*, plus
+
+*maxlevel*
+: the deepest level restored. The subtrees below *maxlevel* are
+skipped while reading: their roots keep the restricted values stored
+in the dump. This gives cheap previews of large snapshots. Default is
+-1 (all levels). Not available with MPI.
+*/
+
 trace
 bool restore (const char * file = "dump",
 	      scalar * list = NULL,
-	      FILE * fp = NULL)
+	      FILE * fp = NULL,
+	      int maxlevel = -1)
 {
   if (!fp && (fp = fopen (file, "r")) == NULL)
     return false;
@@ -1126,6 +1139,10 @@ bool restore (const char * file = "dump",
     fprintf (ferr, "restore(): error: expecting header\n");
     exit (1);
   }
+  if (maxlevel < 0 || maxlevel > header.depth)
+    maxlevel = header.depth;
+  else
+    not_mpi_compatible();
 
 #if TREE
   init_grid (1);
@@ -1150,7 +1167,7 @@ bool restore (const char * file = "dump",
     depth++, n /= 2;
   init_grid (1 << depth);
 #else // !MULTIGRID_MPI
-  init_grid (1 << header.depth);
+  init_grid (1 << maxlevel);
 #endif
 #endif // multigrid
 
@@ -1233,14 +1250,20 @@ bool restore (const char * file = "dump",
 #if TREE && _MPI
   restore_mpi (fp, slist);
 #else
+#if !MULTIGRID_MPI
+  long cell_size = sizeof(unsigned) + header.len*sizeof(double);
+#endif
   foreach_cell() {
     unsigned flags;
     if (fread (&flags, sizeof(unsigned), 1, fp) != 1) {
       fprintf (ferr, "restore(): error: expecting 'flags'\n");
       exit (1);
     }
-    // skip subtree size
-    fseek (fp, sizeof(double), SEEK_CUR);
+    double subtree;
+    if (fread (&subtree, sizeof(double), 1, fp) != 1) {
+      fprintf (ferr, "restore(): error: expecting subtree size\n");
+      exit (1);
+    }
     for (scalar s in slist) {
       double val;
       if (fread (&val, sizeof(double), 1, fp) != 1) {
@@ -1250,6 +1273,14 @@ bool restore (const char * file = "dump",
       if (s.i != INT_MAX)
 	s[] = val;
     }
+    if (!(flags & leaf) && level == maxlevel) {
+      // skip the subtree, using the number of cells it contains
+      if (fseek (fp, (subtree - 1.)*cell_size, SEEK_CUR) < 0) {
+	perror ("restore(): error while seeking");
+	exit (1);
+      }
+      continue;
+    }
     if (!(flags & leaf) && is_leaf(cell))
       refine_cell (point, listm, 0, NULL);
     if (is_leaf(cell))
@@ -27,13 +27,20 @@ approximate solution $\tilde{a}$.
 Here we implement the multigrid cycle proper. Given an initial guess
 *a*, a residual *res*, a correction field *da* and a relaxation
 function *relax*, we will provide an improved guess at the end of the
-cycle. */
+cycle.
+
+If *deferred* is set, the correction is not added to *a* at the end of
+the cycle but is left in *da*. The correction left in *da* by the
+previous (deferred) cycle is then added to *a*, leaf by leaf, in the
+same sweeps which initialise *da* below. This saves one sweep of the
+leaf cells per cycle. */
 
 void mg_cycle (scalar * a, scalar * res, scalar * da,
 	       void (* relax) (scalar * da, scalar * res, 
 			       int depth, void * data),
 	       void * data,
-	       int nrelax, int minlevel, int maxlevel)
+	       int nrelax, int minlevel, int maxlevel,
+	       bool deferred = false)
 {
 
   /**
@@ -52,20 +59,34 @@ void mg_cycle (scalar * a, scalar * res, scalar * da,
     On the coarsest grid, we take zero as initial guess. */
 
     if (l == minlevel)
-      foreach_level_or_leaf (l)
+      foreach_level_or_leaf (l) {
+	if (deferred && is_leaf(cell)) {
+	  scalar s, ds;
+	  for (s, ds in a, da)
+	    foreach_blockf (s)
+	      s[] += ds[];
+	}
 	for (scalar s in da)
 	  foreach_blockf (s)
 	    s[] = 0.;
+      }
 
     /**
     On all other grids, we take as initial guess the approximate solution
     on the coarser grid bilinearly interpolated onto the current grid. */
 
     else
-      foreach_level (l)
+      foreach_level (l) {
+	if (deferred && is_leaf(cell)) {
+	  scalar s, ds;
+	  for (s, ds in a, da)
+	    foreach_blockf (s)
+	      s[] += ds[];
+	}
 	for (scalar s in da)
 	  foreach_blockf (s)
 	    s[] = bilinear (point, s);
+      }
     
     /**
     We then apply homogeneous boundary conditions and do several
@@ -81,12 +102,13 @@ void mg_cycle (scalar * a, scalar * res, scalar * da,
   /**
   And finally we apply the resulting correction to *a*. */
 
-  foreach() {
-    scalar s, ds;
-    for (s, ds in a, da)
-      foreach_blockf (s)
-	s[] += ds[];
-  }
+  if (!deferred)
+    foreach() {
+      scalar s, ds;
+      for (s, ds in a, da)
+	foreach_blockf (s)
+	  s[] += ds[];
+    }
 }
 
 /**
@@ -102,6 +124,23 @@ tolerance by *TOLERANCE* with the default values below. */
 int NITERMAX = 100, NITERMIN = 1;
 double TOLERANCE = 1e-3 [*];
 
+/**
+If *FUSED_RESIDUAL* is set, the residual is not recomputed from *a*
+after each cycle. Since the operator is linear, the new residual is
+$$
+b - L(\tilde{a} + da) = res - L(da)
+$$
+i.e. it is obtained by calling the residual function with *da* and
+*res* (as both the right-hand-side and the result) in place of *a* and
+*b*. The correction *da* is then added to *a* during the next cycle
+(see *deferred* above). This removes a full sweep of the finest level
+per cycle. The residual function must only access the right-hand-side
+at the current cell, which is the case for the solvers of Basilisk.
+The residual is accumulated over the cycles and may thus differ from
+the non-fused version at the level of round-off errors. */
+
+bool FUSED_RESIDUAL = false;
+
 /**
 Information about the convergence of the solver is returned in a structure. */
 
@@ -167,6 +206,9 @@ mgstats mg_solve (scalar * a, scalar * b,
 
   double resb;
   resb = s.resb = s.resa = (* residual) (a, b, res, data);
+  bool fused = FUSED_RESIDUAL;
+  if (fused)
+    reset (da, 0.);
 
   /**
   We then iterate until convergence or until *NITERMAX* is reached. Note
@@ -179,8 +221,12 @@ mgstats mg_solve (scalar * a, scalar * b,
     mg_cycle (a, res, da, relax, data,
 	      s.nrelax,
 	      minlevel,
-	      grid->maxdepth);
-    s.resa = (* residual) (a, b, res, data);
+	      grid->maxdepth,
+	      fused);
+    if (fused)
+      s.resa = (* residual) (da, res, res, data);
+    else
+      s.resa = (* residual) (a, b, res, data);
 
     /**
     We tune the number of relaxations so that the residual is reduced
@@ -205,6 +251,17 @@ mgstats mg_solve (scalar * a, scalar * b,
     resb = s.resa;
   }
   s.minlevel = minlevel;
+
+  /**
+  The correction of the last (deferred) cycle is applied. */
+
+  if (fused)
+    foreach() {
+      scalar v, dc;
+      for (v, dc in a, da)
+	foreach_blockf (v)
+	  v[] += dc[];
+    }
   
   /**
   If we have not satisfied the tolerance, we warn the user. */
@@ -227,6 +284,237 @@ mgstats mg_solve (scalar * a, scalar * b,
   return s;
 }
 
+/**
+## Simultaneous solution of several systems
+
+Independent systems (e.g. several Poisson problems, or the pressure and
+an electric potential) can be solved in lockstep rather than one after
+the other. The V-cycles of all the systems share the traversals of the
+hierarchy (restriction of the residuals, initial guesses and final
+corrections) and the boundary conditions (and thus the MPI halo
+messages) at each level, while each system keeps its own residual and
+relaxation functions, its own number of relaxations and its own
+convergence check. A converged system is left out of the following
+cycles.
+
+The systems are described by an array of the structures below. The
+fields are those of [mg_solve()](#mg_solve), a zero *tolerance* stands
+for *TOLERANCE* and a zero *nrelax* for the default of 4. The
+convergence statistics of each system are returned in *s*. */
+
+typedef struct {
+  scalar * a, * b;
+  double (* residual) (scalar * a, scalar * b, scalar * res, void * data);
+  void (* relax) (scalar * da, scalar * res, int depth, void * data);
+  void * data;
+  int nrelax, minlevel;
+  scalar * res;
+  double tolerance;
+  mgstats s;
+} mgsystem;
+
+static scalar * mg_append (scalar * list, scalar * l)
+{
+  for (scalar s in l)
+    list = list_append (list, s);
+  return list;
+}
+
+/**
+The multigrid cycle for the *active* systems, as in
+[mg_cycle()](#mg_cycle). Each system starts at its own minimum level. */
+
+static void mg_cycle_systems (mgsystem * sys, int n, scalar ** da,
+			      scalar ** res, bool * active, bool deferred)
+{
+  int maxlevel = grid->maxdepth, minlevel = maxlevel;
+  scalar * lres = NULL;
+  for (int k = 0; k < n; k++)
+    if (active[k]) {
+      lres = mg_append (lres, res[k]);
+      minlevel = min (minlevel, sys[k].minlevel);
+    }
+  restriction (lres);
+  free (lres);
+
+  for (int l = max (minlevel, 0); l <= maxlevel; l++) {
+
+    /**
+    The systems starting on this level take zero as initial guess, the
+    others the bilinear interpolation of their coarser solution. */
+
+    scalar * za = NULL, * zda = NULL, * ia = NULL, * ida = NULL, * lda = NULL;
+    int nrelax = 0;
+    for (int k = 0; k < n; k++) {
+      int start = min (sys[k].minlevel, maxlevel);
+      if (active[k] && l >= start) {
+	if (l == start)
+	  za = mg_append (za, sys[k].a), zda = mg_append (zda, da[k]);
+	else
+	  ia = mg_append (ia, sys[k].a), ida = mg_append (ida, da[k]);
+	lda = mg_append (lda, da[k]);
+	nrelax = max (nrelax, sys[k].s.nrelax);
+      }
+    }
+    
+    if (zda)
+      foreach_level_or_leaf (l) {
+	if (deferred && is_leaf(cell)) {
+	  scalar s, ds;
+	  for (s, ds in za, zda)
+	    foreach_blockf (s)
+	      s[] += ds[];
+	}
+	for (scalar s in zda)
+	  foreach_blockf (s)
+	    s[] = 0.;
+      }
+    if (ida)
+      foreach_level (l) {
+	if (deferred && is_leaf(cell)) {
+	  scalar s, ds;
+	  for (s, ds in ia, ida)
+	    foreach_blockf (s)
+	      s[] += ds[];
+	}
+	for (scalar s in ida)
+	  foreach_blockf (s)
+	    s[] = bilinear (point, s);
+      }
+
+    /**
+    The *i*-th relaxations of all the systems (which need it) are
+    followed by a single update of the boundary conditions. */
+    
+    boundary_level (lda, l);
+    for (int i = 0; i < nrelax; i++) {
+      scalar * rda = NULL;
+      for (int k = 0; k < n; k++)
+	if (active[k] && l >= min (sys[k].minlevel, maxlevel) &&
+	    i < sys[k].s.nrelax) {
+	  sys[k].relax (da[k], res[k], l, sys[k].data);
+	  rda = mg_append (rda, da[k]);
+	}
+      boundary_level (rda, l);
+      free (rda);
+    }
+    free (za), free (zda), free (ia), free (ida), free (lda);
+  }
+
+  if (!deferred) {
+    scalar * la = NULL, * lda = NULL;
+    for (int k = 0; k < n; k++)
+      if (active[k])
+	la = mg_append (la, sys[k].a), lda = mg_append (lda, da[k]);
+    foreach() {
+      scalar s, ds;
+      for (s, ds in la, lda)
+	foreach_blockf (s)
+	  s[] += ds[];
+    }
+    free (la), free (lda);
+  }
+}
+
+/**
+The solver proper follows [mg_solve()](#mg_solve) for each system. The
+results are identical to those of separate calls to *mg_solve()*. */
+
+void mg_solve_systems (mgsystem * sys, int n)
+{
+  scalar ** da = malloc (n*sizeof(scalar *)), ** res = malloc (n*sizeof(scalar *));
+  scalar * rhs = NULL;
+  bool * active = malloc (n*sizeof(bool));
+  double * resb = malloc (n*sizeof(double)), * tolerance = malloc (n*sizeof(double));
+  bool fused = FUSED_RESIDUAL;
+  for (int k = 0; k < n; k++) {
+    mgsystem * p = &sys[k];
+    da[k] = list_clone (p->a);
+    res[k] = p->res ? p->res : list_clone (p->b);
+    for (int b = 0; b < nboundary; b++)
+      for (scalar s in da[k])
+	s.boundary[b] = s.boundary_homogeneous[b];
+    rhs = list_append (rhs, p->b[0]);
+    tolerance[k] = p->tolerance ? p->tolerance : TOLERANCE;
+    p->s = (mgstats){0};
+    p->s.nrelax = p->nrelax > 0 ? p->nrelax : 4;
+    p->s.minlevel = p->minlevel;
+  }
+
+  /**
+  The sums of the right-hand-sides are computed in a single sweep. */
+  
+  double * sum = calloc (n, sizeof(double));
+  foreach (reduction(+:sum[:n])) {
+    int k = 0;
+    for (scalar s in rhs)
+      sum[k++] += s[];
+  }
+  
+  for (int k = 0; k < n; k++) {
+    mgsystem * p = &sys[k];
+    p->s.sum = sum[k];
+    resb[k] = p->s.resb = p->s.resa = p->residual (p->a, p->b, res[k], p->data);
+    if (fused)
+      reset (da[k], 0.);
+  }
+
+  for (int i = 0; i < NITERMAX; i++) {
+    int nactive = 0;
+    for (int k = 0; k < n; k++)
+      nactive += active[k] = (i < NITERMIN || sys[k].s.resa > tolerance[k]);
+    if (!nactive)
+      break;
+    mg_cycle_systems (sys, n, da, res, active, fused);
+    for (int k = 0; k < n; k++)
+      if (active[k]) {
+	mgsystem * p = &sys[k];
+	if (fused)
+	  p->s.resa = p->residual (da[k], res[k], res[k], p->data);
+	else
+	  p->s.resa = p->residual (p->a, p->b, res[k], p->data);
+	if (p->s.resa > tolerance[k]) {
+	  if (resb[k]/p->s.resa < 1.2 && p->s.nrelax < 100)
+	    p->s.nrelax++;
+	  else if (resb[k]/p->s.resa > 10 && p->s.nrelax > 2)
+	    p->s.nrelax--;
+	}
+	resb[k] = p->s.resa;
+	p->s.i++;
+      }
+  }
+
+  if (fused) {
+    scalar * la = NULL, * lda = NULL;
+    for (int k = 0; k < n; k++)
+      la = mg_append (la, sys[k].a), lda = mg_append (lda, da[k]);
+    foreach() {
+      scalar v, dc;
+      for (v, dc in la, lda)
+	foreach_blockf (v)
+	  v[] += dc[];
+    }
+    free (la), free (lda);
+  }
+
+  for (int k = 0; k < n; k++) {
+    mgsystem * p = &sys[k];
+    if (p->s.resa > tolerance[k]) {
+      scalar v = p->a[0];
+      fprintf (ferr, 
+	       "WARNING: convergence for %s not reached after %d iterations\n"
+	       "  res: %g sum: %g nrelax: %d tolerance: %g\n", v.name,
+	       p->s.i, p->s.resa, p->s.sum, p->s.nrelax, tolerance[k]),
+	fflush (ferr);
+    }
+    if (!p->res)
+      delete (res[k]), free (res[k]);
+    delete (da[k]), free (da[k]);
+  }
+  free (da), free (res), free (rhs), free (active), free (resb);
+  free (tolerance), free (sum);
+}
+
 /**
 ## Application to the Poisson--Helmholtz equation
 
@@ -443,6 +731,57 @@ mgstats poisson (scalar a, scalar b,
   return s;
 }
 
+/**
+Several Poisson--Helmholtz problems are solved in lockstep (see
+[mg_solve_systems()](#simultaneous-solution-of-several-systems)) with
+an array of *Poisson* structures. Unlike *poisson()*, $\alpha$ and
+$\lambda$ must be set (possibly as constant fields, e.g. *unityf* and
+*zeroc*), and the minimum level is at least one. The statistics of
+each problem are returned in *s*, if given.
+
+~~~literatec
+struct Poisson p[2] = {
+  {.a = phi, .b = rhs, .alpha = epsilon, .lambda = zeroc},
+  {.a = c, .b = src, .alpha = D, .lambda = kappa, .tolerance = 1e-6}
+};
+poisson_systems (p, 2);
+~~~
+*/
+
+void poisson_systems (struct Poisson * p, int n, mgstats * s = NULL)
+{
+  mgsystem * sys = calloc (n, sizeof(mgsystem));
+  scalar * coefficients = NULL;
+  for (int k = 0; k < n; k++) {
+    foreach_dimension()
+      coefficients = list_add (coefficients, p[k].alpha.x);
+    coefficients = list_add (coefficients, p[k].lambda);
+#if EMBED
+    if (!p[k].embed_flux && p[k].a.boundary[embed] != symmetry)
+      p[k].embed_flux = embed_flux;
+#endif // EMBED
+    sys[k].a = list_append (NULL, p[k].a);
+    sys[k].b = list_append (NULL, p[k].b);
+    sys[k].residual = residual, sys[k].relax = relax;
+    sys[k].data = &p[k];
+    sys[k].nrelax = p[k].nrelax;
+    sys[k].minlevel = max(1, p[k].minlevel);
+    sys[k].res = p[k].res;
+    sys[k].tolerance = p[k].tolerance;
+  }
+  restriction (coefficients);
+  free (coefficients);
+
+  mg_solve_systems (sys, n);
+
+  for (int k = 0; k < n; k++) {
+    if (s)
+      s[k] = sys[k].s;
+    free (sys[k].a), free (sys[k].b);
+  }
+  free (sys);
+}
+
 /**
 ## Projection of a velocity field
 
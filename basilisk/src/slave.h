@@ -31,6 +31,172 @@ double slave_interpolate (const char * name, double xp, double yp, double zp, bo
   return interpolate (s, xp, yp, zp, linear);
 }
 
+/**
+## Batched coupling functions
+
+When many points are exchanged at each step (e.g. boundary data on
+whole faces), calling *slave_interpolate()* for each point repeats the
+field lookup and the *locate()* of the cell. Instead, the master
+registers a named set of points once with *slave_points()*, which
+returns its index. The values of a list of fields (a NULL-terminated
+array of names) are then exchanged as packed arrays, with *n*
+consecutive blocks of one value per field:
+
+* *slave_get()* interpolates the slave fields at the points (the
+  values are *nodata* outside the slave domain);
+* *slave_put()* sets the slave fields in the cells containing the
+  points, for example the boundary values used by the boundary
+  conditions of the slave.
+
+For example, on the master
+
+~~~literatec
+static int inflow = -1;
+if (inflow < 0)
+  inflow = slave_points ("inflow", p, n);
+double v[2*n];
+slave_get (inflow, (const char *[]){"u.x", "u.y", NULL}, v, linear = true);
+~~~
+
+The cells containing the points are cached. The cache is checked at
+each exchange: a point is located again only if its cell is no longer
+a local leaf (after adaptation or load balancing). With MPI, each
+point is handled by the process which owns its cell and *slave_get()*
+only needs one reduction for the whole array.
+
+As for *slave_interpolate()*, these functions must be exported when
+compiling `slave.o`. */
+
+typedef struct {
+  char * name;
+  int n;
+  coord * p;
+  Point * cells;
+} SlavePoints;
+
+static SlavePoints * slave_sets = NULL;
+static int slave_nsets = 0;
+
+static bool slave_cell (Point point)
+{
+  if (point.level < 0)
+    return false;
+#if TREE
+  return point.level <= depth() && allocated(0) &&
+    is_local(cell) && is_leaf(cell);
+#else
+  return true;
+#endif
+}
+
+static SlavePoints * slave_locate (int set)
+{
+  if (!grid || set < 0 || set >= slave_nsets) {
+    fprintf (stderr, "slave coupling: error: invalid set %d or no grid\n", set);
+    exit (1);
+  }
+  SlavePoints * s = &slave_sets[set];
+
+  /**
+  If the cell of a local point has changed, the points which are not
+  local may also have moved to this process. */
+  
+  int changed = 0;
+  for (int i = 0; i < s->n; i++)
+    if (s->cells[i].level >= 0 && !slave_cell (s->cells[i])) {
+      s->cells[i] = locate (s->p[i].x, s->p[i].y, s->p[i].z);
+      changed = 1;
+    }
+#if _MPI
+  mpi_all_reduce (changed, MPI_INT, MPI_MAX);
+  if (changed)
+    for (int i = 0; i < s->n; i++)
+      if (s->cells[i].level < 0)
+	s->cells[i] = locate (s->p[i].x, s->p[i].y, s->p[i].z);
+#endif
+  return s;
+}
+
+static scalar * slave_fields (const char ** fields)
+{
+  scalar * list = NULL;
+  for (const char ** name = fields; *name; name++) {
+    scalar s = lookup_field (*name);
+    if (s.i < 0) {
+      fprintf (stderr, "slave coupling: error: unknown field '%s'\n", *name);
+      exit (1);
+    }
+    list = list_append (list, s);
+  }
+  return list;
+}
+
+static void slave_values (Point point, scalar * list, coord p, double * v,
+			  bool linear)
+{
+  for (scalar f in list)
+    *(v++) = linear ? interpolate_linear (point, f, p.x, p.y, p.z) : f[];
+}
+
+static void slave_set_values (Point point, scalar * list, double * v)
+{
+  for (scalar f in list)
+    f[] = *(v++);
+}
+
+int slave_points (const char * name, coord * p, int n)
+{
+  int set = 0;
+  while (set < slave_nsets && strcmp (slave_sets[set].name, name))
+    set++;
+  if (set == slave_nsets) {
+    slave_sets = realloc (slave_sets, ++slave_nsets*sizeof(SlavePoints));
+    slave_sets[set] = (SlavePoints){ strdup (name) };
+  }
+  SlavePoints * s = &slave_sets[set];
+  s->n = n;
+  s->p = realloc (s->p, n*sizeof(coord));
+  s->cells = realloc (s->cells, n*sizeof(Point));
+  for (int i = 0; i < n; i++) {
+    s->p[i] = p[i];
+    s->cells[i] = locate (p[i].x, p[i].y, p[i].z);
+  }
+  return set;
+}
+
+void slave_get (int set, const char ** fields, double * v, bool linear)
+{
+  SlavePoints * s = slave_locate (set);
+  scalar * list = slave_fields (fields);
+  int len = list_len (list);
+  if (linear)
+    boundary (list);
+  for (int i = 0; i < s->n; i++)
+    if (s->cells[i].level >= 0)
+      slave_values (s->cells[i], list, s->p[i], v + i*len, linear);
+    else
+      for (int j = 0; j < len; j++)
+	v[i*len + j] = nodata;
+#if _MPI
+  MPI_Allreduce (MPI_IN_PLACE, v, s->n*len, MPI_DOUBLE, MPI_MIN,
+		 MPI_COMM_WORLD);
+#endif
+  free (list);
+}
+
+void slave_put (int set, const char ** fields, double * v)
+{
+  SlavePoints * s = slave_locate (set);
+  scalar * list = slave_fields (fields);
+  int len = list_len (list);
+  for (int i = 0; i < s->n; i++)
+    if (s->cells[i].level >= 0)
+      slave_set_values (s->cells[i], list, v + i*len);
+  for (scalar f in list)
+    f.dirty = true;
+  free (list);
+}
+
 /**
 ## Synchronization functions
 
@@ -68,6 +234,11 @@ void slave_step (double t0)
 
 void slave_stop()
 {
+  for (int i = 0; i < slave_nsets; i++) {
+    SlavePoints * s = &slave_sets[i];
+    free (s->name), free (s->p), free (s->cells);
+  }
+  free (slave_sets), slave_sets = NULL, slave_nsets = 0;
   free_grid();
 }
 
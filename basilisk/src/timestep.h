@@ -1,7 +1,22 @@
+/**
+The timestep is not allowed to increase by more than 10% (roughly)
+from one step to the next. The minimum over the faces of the CFL
+timestep (*dtmax* on input) can also be computed elsewhere, e.g. fused
+with another loop over faces, and passed to *timestep_update()*. */
+
+double timestep_update (double dtmax)
+{
+  static double previous = 0.;
+  dtmax *= CFL;
+  if (dtmax > previous)
+    dtmax = (previous + 0.1*dtmax)/1.1;
+  previous = dtmax;
+  return dtmax;
+}
+
 // note: u is weighted by fm
 double timestep (const face vector u, double dtmax)
 {
-  static double previous = 0.;
   dtmax /= CFL;
   foreach_face(reduction(min:dtmax))
     if (u.x[] != 0.) {
@@ -14,9 +29,5 @@ double timestep (const face vector u, double dtmax)
 #endif
       if (dt < dtmax) dtmax = dt;
     }
-  dtmax *= CFL;
-  if (dtmax > previous)
-    dtmax = (previous + 0.1*dtmax)/1.1;
-  previous = dtmax;
-  return dtmax;
+  return timestep_update (dtmax);
 }
@@ -0,0 +1,281 @@
+/** Title: async-diagnostics.h
+# Version: 1.0
+# Main feature: Read-only diagnostics run on a helper thread, concurrently with the next timestep.
+
+# Author: Vatsal Sanjay
+# vatsalsanjay@gmail.com
+# Physics of Fluids
+# Updated: Oct 18, 2026
+
+# change log: Oct 18, 2026 (v1.0)
+- async_diagnostic(): snapshot of the fields read by a diagnostic, processed on a helper thread.
+- async_wait(): waits for the pending diagnostics.
+
+# Why?
+Events like `logWriting`, in-situ statistics or movie frames only read
+the solver fields, yet they run inline in `events()` and the next
+timestep waits for their file output and post-processing. Here such a
+diagnostic is split in two:
+
+* the event copies what it reads (the leaf values of a list of fields
+  and, optionally, a block of values already computed, e.g. reductions)
+  into a flat snapshot. This is a single pass over the leaves;
+* a callback processes the snapshot on a helper thread while the
+  solver advances.
+
+Diagnostics must be marked explicitly: qcc does not tell which events
+are read-only.
+
+# Usage
+
+~~~literatec
+#include "../src-local/async-diagnostics.h"
+
+static void stretch (const AsyncSnapshot * s)
+{
+  double amax = 0.;
+  for (long j = 0; j < s->n; j++)
+    if (s->v[0][j] > amax)
+      amax = s->v[0][j];
+  FILE * fp = fopen ("stretch.dat", s->i == 0 ? "w" : "a");
+  fprintf (fp, "%g %g %g\n", s->t, amax, *(double *) s->data);
+  fclose (fp);
+}
+
+event stretchStats (i += 10) {
+  double ke = ...; // reductions stay in the event
+  async_diagnostic (stretch, {A11}, &ke, sizeof(double));
+}
+~~~
+
+Link with `-lpthread` (or use `qcc -autolink`).
+
+# Ordering and snapshots
+Diagnostics are processed one at a time, in the order they were
+submitted, so that their output files are written in order. There are
+*ASYNC_SLOTS* (two by default) snapshots: while one is processed, the
+next is filled. If the helper thread falls behind, the solver waits
+for a free snapshot. The pending diagnostics are completed at the end
+of the run, or by calling *async_wait()*.
+
+The callback only sees the snapshot: it must not use the grid, fields,
+`foreach()` or MPI, since the solver is modifying them concurrently.
+Global variables read by the callback must not change during the run.
+
+With MPI, each process has its own helper thread and the snapshot
+holds its own leaves only (*s->pid* can be used to name per-process
+files). Global quantities (reductions, `statsf()`, ...) must be
+computed in the event and passed through *data*.
+
+Setting *async_diagnostics* to false processes the snapshots inline,
+which is useful for debugging and timing.
+*/
+
+#include <pthread.h>
+#pragma autolink -lpthread
+
+#ifndef ASYNC_SLOTS
+# define ASYNC_SLOTS 2
+#endif
+
+bool async_diagnostics = true;
+
+/**
+The snapshot seen by the callback. *v[k][j]* is the value of the
+*k*-th field of the list in the *j*-th leaf cell, of centre
+(*x[j]*, *y[j]*, *z[j]*) and size *Delta[j]* (*z* is NULL in 2D). */
+
+typedef struct {
+  int i, pid;
+  double t, dt;
+  long n;
+  int nf;
+  double * x, * y, * z, * Delta;
+  double ** v;
+  const void * data;
+  size_t size;
+} AsyncSnapshot;
+
+typedef void (* AsyncDiagnostic) (const AsyncSnapshot * s);
+
+typedef struct {
+  AsyncSnapshot s;
+  AsyncDiagnostic diagnostic;
+  double * buf;
+  long len;
+  void * data;
+} AsyncSlot;
+
+/**
+The queue holds the slots *head* to *head + count - 1* (modulo
+*ASYNC_SLOTS*); the slot at *head* is the one being processed. */
+
+static struct {
+  AsyncSlot slot[ASYNC_SLOTS];
+  int head, count;
+  bool running, stop;
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t queued, freed;
+} async;
+
+static void * async_worker (void * p)
+{
+  pthread_mutex_lock (&async.lock);
+  while (true) {
+    while (!async.count && !async.stop)
+      pthread_cond_wait (&async.queued, &async.lock);
+    if (!async.count)
+      break;
+    AsyncSlot * s = &async.slot[async.head];
+    pthread_mutex_unlock (&async.lock);
+    s->diagnostic (&s->s);
+    pthread_mutex_lock (&async.lock);
+    async.head = (async.head + 1) % ASYNC_SLOTS, async.count--;
+    pthread_cond_broadcast (&async.freed);
+  }
+  pthread_mutex_unlock (&async.lock);
+  return NULL;
+}
+
+/**
+## *async_wait()*
+
+Returns when all the submitted diagnostics have been processed. */
+
+void async_wait (void)
+{
+  if (!async.running)
+    return;
+  pthread_mutex_lock (&async.lock);
+  while (async.count)
+    pthread_cond_wait (&async.freed, &async.lock);
+  pthread_mutex_unlock (&async.lock);
+}
+
+/**
+The snapshot of the leaves of *list*, with the current time. Without
+a list, the snapshot holds no cells, only *data*. */
+
+static void async_fill (AsyncSlot * s, AsyncDiagnostic diagnostic, scalar * list,
+			const void * data, size_t size)
+{
+  long n = 0;
+  if (list)
+    foreach (serial)
+      n++;
+  int nf = list_len (list);
+  long len = (dimension + 1 + nf)*n;
+  if (len > s->len) {
+    s->buf = realloc (s->buf, len*sizeof(double));
+    s->len = len;
+  }
+  s->s.v = realloc (s->s.v, max(nf, 1)*sizeof(double *));
+  double * b = s->buf;
+  s->s.x = b, b += n;
+  s->s.y = b, b += n;
+#if dimension == 3
+  s->s.z = b, b += n;
+#else
+  s->s.z = NULL;
+#endif
+  s->s.Delta = b, b += n;
+  for (int k = 0; k < nf; k++)
+    s->s.v[k] = b, b += n;
+
+  long j = 0;
+  if (list)
+    foreach (serial) {
+      s->s.x[j] = x, s->s.y[j] = y;
+#if dimension == 3
+      s->s.z[j] = z;
+#endif
+      s->s.Delta[j] = Delta;
+      int k = 0;
+      for (scalar f in list)
+	s->s.v[k++][j] = f[];
+      j++;
+    }
+
+  s->data = realloc (s->data, max(size, 1));
+  if (size)
+    memcpy (s->data, data, size);
+  s->s.data = size ? s->data : NULL;
+  s->s.size = size;
+  s->s.i = iter, s->s.pid = pid();
+  s->s.t = t, s->s.dt = dt;
+  s->s.n = n, s->s.nf = nf;
+  s->diagnostic = diagnostic;
+}
+
+/**
+## *async_diagnostic()*
+
+Submits *diagnostic* for the snapshot of the fields of *list* and of the
+*size* bytes at *data*. Returns as soon as the snapshot is taken. */
+
+trace
+void async_diagnostic (AsyncDiagnostic diagnostic, scalar * list = NULL,
+		       const void * data = NULL, size_t size = 0)
+{
+  if (!async_diagnostics) {
+    async_wait();
+    AsyncSlot * s = &async.slot[async.head];
+    async_fill (s, diagnostic, list, data, size);
+    s->diagnostic (&s->s);
+    return;
+  }
+
+  if (!async.running) {
+    pthread_mutex_init (&async.lock, NULL);
+    pthread_cond_init (&async.queued, NULL);
+    pthread_cond_init (&async.freed, NULL);
+    async.stop = false;
+    if (pthread_create (&async.thread, NULL, async_worker, NULL)) {
+      fprintf (ferr, "async_diagnostic(): could not create thread\n");
+      exit (1);
+    }
+    async.running = true;
+  }
+
+  /**
+  The slot after the queue is not touched by the helper thread, so it
+  is filled without holding the lock. */
+
+  pthread_mutex_lock (&async.lock);
+  while (async.count == ASYNC_SLOTS)
+    pthread_cond_wait (&async.freed, &async.lock);
+  AsyncSlot * s = &async.slot[(async.head + async.count) % ASYNC_SLOTS];
+  pthread_mutex_unlock (&async.lock);
+
+  async_fill (s, diagnostic, list, data, size);
+
+  pthread_mutex_lock (&async.lock);
+  async.count++;
+  pthread_cond_signal (&async.queued);
+  pthread_mutex_unlock (&async.lock);
+}
+
+/**
+The pending diagnostics are completed after all the other events of
+the last timestep. */
+
+event async_cleanup (t = end, last)
+{
+  if (async.running) {
+    pthread_mutex_lock (&async.lock);
+    async.stop = true;
+    pthread_cond_signal (&async.queued);
+    pthread_mutex_unlock (&async.lock);
+    pthread_join (async.thread, NULL);
+    pthread_mutex_destroy (&async.lock);
+    pthread_cond_destroy (&async.queued);
+    pthread_cond_destroy (&async.freed);
+    async.running = false;
+  }
+  for (int k = 0; k < ASYNC_SLOTS; k++) {
+    AsyncSlot * s = &async.slot[k];
+    free (s->buf), free (s->s.v), free (s->data);
+    s->buf = NULL, s->s.v = NULL, s->data = NULL, s->len = 0;
+  }
+}
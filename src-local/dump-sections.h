@@ -0,0 +1,443 @@
+/** Title: dump-sections.h
+# Version: 1.2
+# Main feature: Self-describing snapshots where each field is stored as a separate contiguous section.
+
+# Author: Vatsal Sanjay
+# vatsalsanjay@gmail.com
+# Physics of Fluids
+# Updated: Oct 18, 2026
+
+# change log: Oct 18, 2026 (v1.0)
+- dump_sections() and restore_sections(): tree topology stored once, one section per field, offset table in the header.
+- restore_sections() falls back to [restore()](http://basilisk.fr/src/output.h) for standard Basilisk dumps.
+
+# change log: Oct 18, 2026 (v1.1)
+- fields with the *single* attribute are stored in single precision. Files written by v1.0 can still be restored.
+
+# change log: Oct 18, 2026 (v1.2)
+- restore_sections (..., maxlevel = L): the subtrees below level L are skipped, for previews.
+
+# Why?
+[dump()](http://basilisk.fr/src/output.h) interleaves all the fields
+cell by cell (flags, then every scalar of that cell). A post-processing
+tool which only needs *f* (e.g. [getFacet2D.c](../testCases/getFacet2D.c))
+still has to read every byte of the snapshot.
+
+Here, the file is organised as
+
+* a header (time, iteration, depth, number of cells and fields, domain),
+* a table with the name, the element size and the file offset of each
+  field section,
+* the topology section: one byte per cell, in the order of *foreach_cell()*,
+* one contiguous section of doubles per field, in the same order.
+  Fields with the *single* attribute (e.g. `KAPPA.single = true;`)
+  are stored as floats.
+
+Restricted (parent) values are stored as well, so that the result of
+*restore_sections()* is identical to that of *restore()*. Only the
+sections of the requested fields are read.
+
+# Usage
+
+~~~literatec
+#include "../src-local/dump-sections.h"
+
+event writingFiles (t = 0; t += tsnap; t <= tmax) {
+  sprintf (nameOut, "intermediate/snapshot-%5.4f", t);
+  dump_sections (file = nameOut);
+}
+~~~
+
+and in the post-processing tool
+
+~~~literatec
+restore_sections (file = filename, list = {f});
+~~~
+
+For previews, *maxlevel* caps the restored tree: the cells of level
+*maxlevel* keep the restricted values of their subtrees, which are not
+read.
+
+Writing works with MPI. Restoring is serial: under MPI, restarts should
+use the standard *dump()* and *restore()* pair.
+*/
+
+#include "output.h"
+
+#define SECTIONS_MAGIC "BSECTION"
+
+struct SectionsHeader {
+  char magic[8];
+  double t;
+  long ncells;
+  int i, depth, npe, version, nfields, dim;
+  double origin[4];
+};
+
+/**
+Version 261018 (v1.0) has no element size in the offset table: all
+the sections are doubles. */
+
+static const int sections_version = 261019, sections_version_double = 261018;
+
+static unsigned sections_size (scalar s)
+{
+  return s.single ? sizeof(float) : sizeof(double);
+}
+
+/**
+The header and the offset table are written by the master process
+only. Their size is known beforehand, so that every process can
+compute the offsets of the sections. */
+
+static long sections_header_size (scalar * list)
+{
+  long size = sizeof(struct SectionsHeader);
+  for (scalar s in list)
+    size += 2*sizeof(unsigned) + strlen(s.name) + sizeof(long);
+  return size;
+}
+
+static void sections_header (FILE * fp, struct SectionsHeader * header,
+			     scalar * list)
+{
+  if (fwrite (header, sizeof(struct SectionsHeader), 1, fp) < 1) {
+    perror ("dump_sections(): error while writing header");
+    exit (1);
+  }
+  long offset = sections_header_size (list) + header->ncells;
+  for (scalar s in list) {
+    unsigned len = strlen(s.name), size = sections_size (s);
+    if (fwrite (&len, sizeof(unsigned), 1, fp) < 1 ||
+	fwrite (s.name, sizeof(char), len, fp) < len ||
+	fwrite (&size, sizeof(unsigned), 1, fp) < 1 ||
+	fwrite (&offset, sizeof(long), 1, fp) < 1) {
+      perror ("dump_sections(): error while writing the offset table");
+      exit (1);
+    }
+    offset += header->ncells*size;
+  }
+}
+
+/**
+The level of each cell follows from the leaf flags of the cells before
+it, in the order of *foreach_cell()*, by counting the siblings left at
+each level. */
+
+typedef struct {
+  int level, left[64];
+} SectionsCursor;
+
+static void sections_advance (SectionsCursor * c, bool isleaf)
+{
+  c->left[c->level]--;
+  if (!isleaf)
+    c->left[++c->level] = 1 << dimension;
+  else
+    while (c->level > 0 && c->left[c->level] == 0)
+      c->level--;
+}
+
+/**
+## *dump_sections()*
+
+The arguments are the same as for *dump()*: the name of the *file*
+and the *list* of fields (face fields and fields marked *nodump* are
+skipped). The file is first written with a "~" suffix and renamed
+once complete, unless *unbuffered* is set. */
+
+trace
+void dump_sections (const char * file = "dump",
+		    scalar * list = all,
+		    bool unbuffered = false)
+{
+  char name[strlen(file) + 2];
+  strcpy (name, file);
+  if (!unbuffered)
+    strcat (name, "~");
+
+  scalar * slist = dump_list (list);
+  struct SectionsHeader header = { SECTIONS_MAGIC, t, 0, iter, depth(), npe(),
+				   sections_version, list_len (slist), dimension,
+				   {X0, Y0, Z0, L0} };
+
+#if _MPI
+  scalar index[];
+  header.ncells = z_indexing (index, false) + 1;
+  mpi_all_reduce (header.ncells, MPI_LONG, MPI_MAX);
+  FILE * fp = NULL;
+  // the file must exist before the other processes open it
+  if (pid() == 0) {
+    if ((fp = fopen (name, "w")) == NULL) {
+      perror (name);
+      exit (1);
+    }
+    sections_header (fp, &header, slist);
+    fflush (fp);
+  }
+  MPI_Barrier (MPI_COMM_WORLD);
+  if (pid() > 0)
+    fp = fopen (name, "r+");
+#else
+  foreach_cell() {
+    header.ncells++;
+    if (is_leaf(cell))
+      continue;
+  }
+  FILE * fp = fopen (name, "w");
+  if (fp)
+    sections_header (fp, &header, slist);
+#endif
+  if (fp == NULL) {
+    perror (name);
+    exit (1);
+  }
+
+  /**
+  Each section is written by traversing the tree once. With MPI, each
+  process writes its local cells at the position given by their
+  Z-ordering index, seeking only when the local cells are not
+  contiguous. */
+
+  long section = sections_header_size (slist), pos = -1;
+  for (int k = -1; k < header.nfields; k++) {
+    scalar s = k < 0 ? (scalar){-1} : slist[k];
+    size_t size = k < 0 ? sizeof(unsigned char) : sections_size (s);
+    if (k >= 0)
+      section += header.ncells*(k == 0 ? sizeof(unsigned char) :
+				sections_size (slist[k - 1]));
+#if !_MPI
+    long index = 0;
+#endif
+    foreach_cell() {
+#if _MPI
+      if (is_local(cell)) {
+	long offset = section + index[]*size;
+#else
+      {
+	long offset = section + (index++)*size;
+#endif
+	if (pos != offset && fseek (fp, offset, SEEK_SET) < 0) {
+	  perror ("dump_sections(): error while seeking");
+	  exit (1);
+	}
+	size_t w;
+	if (k < 0) {
+	  unsigned char flags = is_leaf(cell);
+	  w = fwrite (&flags, size, 1, fp);
+	}
+	else if (s.single) {
+	  float val = s[];
+	  w = fwrite (&val, size, 1, fp);
+	}
+	else
+	  w = fwrite (&s[], size, 1, fp);
+	if (w < 1) {
+	  perror ("dump_sections(): error while writing");
+	  exit (1);
+	}
+	pos = offset + size;
+      }
+      if (is_leaf(cell))
+	continue;
+    }
+  }
+
+  free (slist);
+  fclose (fp);
+#if _MPI
+  MPI_Barrier (MPI_COMM_WORLD);
+  if (!unbuffered && pid() == 0)
+#else
+  if (!unbuffered)
+#endif
+    rename (name, file);
+}
+
+/**
+Once the fields of *input* are restored, the other fields are reset
+to zero and the events are advanced to catch up with time *t1* and
+iteration *i1*. */
+
+static void sections_restored (scalar * input, scalar * listm,
+			       double t1, int i1)
+{
+  for (scalar s in all)
+    s.dirty = true;
+
+  scalar * other = NULL;
+  for (scalar s in all)
+    if (!list_lookup (input, s) && !list_lookup (listm, s))
+      other = list_append (other, s);
+  reset (other, 0.);
+  free (other);
+
+  while (iter < i1 && events (false))
+    iter = inext;
+  events (false);
+  while (t < t1 && events (false))
+    t = tnext;
+  t = t1;
+  events (false);
+}
+
+/**
+## *restore_sections()*
+
+Restores the fields of *list* (default *all*) from *file*. Fields of
+*list* which are not in the file and all the other fields are reset to
+zero. The tree is restored down to *maxlevel* (default all levels). If
+*file* is not a section snapshot, this falls back to *restore()*.
+Returns false if the file cannot be opened. */
+
+trace
+bool restore_sections (const char * file = "dump",
+		       scalar * list = NULL,
+		       int maxlevel = -1)
+{
+  FILE * fp = fopen (file, "r");
+  if (fp == NULL)
+    return false;
+
+  struct SectionsHeader header;
+  if (fread (&header, sizeof(header), 1, fp) < 1 ||
+      strncmp (header.magic, SECTIONS_MAGIC, 8)) {
+    fclose (fp);
+    return restore (file = file, list = list, maxlevel = maxlevel);
+  }
+  if (header.version != sections_version &&
+      header.version != sections_version_double) {
+    fprintf (ferr,
+	     "restore_sections(): error: file version mismatch: "
+	     "%d (file) != %d (code)\n",
+	     header.version, sections_version);
+    exit (1);
+  }
+  if (header.dim != dimension) {
+    fprintf (ferr,
+	     "restore_sections(): error: dimension mismatch: "
+	     "%d (file) != %d (code)\n",
+	     header.dim, dimension);
+    exit (1);
+  }
+  not_mpi_compatible();
+  if (maxlevel < 0 || maxlevel > header.depth)
+    maxlevel = header.depth;
+
+  /**
+  The offset table is matched against the requested fields. */
+
+  scalar * slist = dump_list (list ? list : all), * input = NULL;
+  long * offsets = NULL;
+  unsigned * sizes = NULL;
+  int n = 0;
+  for (int k = 0; k < header.nfields; k++) {
+    unsigned len, size = sizeof(double);
+    long offset;
+    if (fread (&len, sizeof(unsigned), 1, fp) < 1) {
+      fprintf (ferr, "restore_sections(): error: expecting len\n");
+      exit (1);
+    }
+    char name[len + 1];
+    if (fread (name, sizeof(char), len, fp) < len ||
+	(header.version != sections_version_double &&
+	 fread (&size, sizeof(unsigned), 1, fp) < 1) ||
+	fread (&offset, sizeof(long), 1, fp) < 1) {
+      fprintf (ferr, "restore_sections(): error: expecting offset table\n");
+      exit (1);
+    }
+    name[len] = '\0';
+    for (scalar s in slist)
+      if (!strcmp (s.name, name)) {
+	input = list_append (input, s);
+	offsets = realloc (offsets, (n + 1)*sizeof(long));
+	sizes = realloc (sizes, (n + 1)*sizeof(unsigned));
+	offsets[n] = offset, sizes[n++] = size;
+	break;
+      }
+  }
+  free (slist);
+
+  /**
+  The topology section directly follows the offset table. Only the
+  cells down to *maxlevel* are kept. */
+
+  unsigned char * flags = malloc (max(header.ncells,1));
+  if (fread (flags, 1, header.ncells, fp) < header.ncells) {
+    fprintf (ferr, "restore_sections(): error: expecting 'flags'\n");
+    exit (1);
+  }
+  long * kept = malloc (max(header.ncells,1)*sizeof(long)), nk = 0;
+  SectionsCursor c = { .level = 0 };
+  c.left[0] = 1;
+  for (long i = 0; i < header.ncells; i++) {
+    if (c.level <= maxlevel)
+      kept[nk++] = i;
+    sections_advance (&c, flags[i]);
+  }
+
+  /**
+  The tree is rebuilt from the kept cells. */
+
+#if TREE
+  init_grid (1);
+  foreach_cell() {
+    cell.pid = pid();
+    cell.flags |= active;
+  }
+  tree->dirty = true;
+#else // multigrid
+  init_grid (1 << maxlevel);
+#endif
+  origin (header.origin[0], header.origin[1], header.origin[2]);
+  size (header.origin[3]);
+
+  scalar * listm = is_constant(cm) ? NULL : (scalar *){fm};
+  long j = 0;
+#if TREE
+  foreach_cell() {
+    if (!flags[kept[j++]] && is_leaf(cell) && level < maxlevel)
+      refine_cell (point, listm, 0, NULL);
+    if (is_leaf(cell))
+      continue;
+  }
+#endif
+  free (flags);
+
+  /**
+  Only the sections of the requested fields are read, seeking over the
+  skipped subtrees. */
+
+  int k = 0;
+  for (scalar s in input) {
+    unsigned size = sizes[k];
+    long section = offsets[k++], pos = -1;
+    j = 0;
+    foreach_cell() {
+      long offset = section + kept[j++]*size;
+      if (pos != offset && fseek (fp, offset, SEEK_SET) < 0) {
+	perror ("restore_sections(): error while seeking");
+	exit (1);
+      }
+      pos = offset + size;
+      double val;
+      float fval;
+      if (size == sizeof(float) ? fread (&fval, size, 1, fp) != 1 :
+	  fread (&val, size, 1, fp) != 1) {
+	fprintf (ferr, "restore_sections(): error: expecting a scalar\n");
+	exit (1);
+      }
+      s[] = size == sizeof(float) ? fval : val;
+      if (is_leaf(cell))
+	continue;
+    }
+  }
+  free (offsets);
+  free (sizes);
+  free (kept);
+  fclose (fp);
+  sections_restored (input, listm, header.t, header.i);
+  free (input);
+
+  return true;
+}
@@ -0,0 +1,34 @@
+/** Title: fene-p-3D.h
+# Version: 1.0
+# Main feature: FENE-P model for the 3D scalar log-conformation solver.
+
+# Author: Vatsal Sanjay
+# vatsalsanjay@gmail.com
+# Physics of Fluids
+# Updated: Oct 18, 2026
+
+# change log: Oct 18, 2026 (v1.0)
+- First version.
+
+# Usage
+Include this file instead of
+[log-conform-viscoelastic-scalar-3D.h](log-conform-viscoelastic-scalar-3D.h)
+and set the square of the maximum extensibility *L2* (default 100) in *main()*
+
+~~~literatec
+#include "../src-local/fene-p-3D.h"
+...
+int main() {
+  L2 = 50.;
+  ...
+}
+~~~
+
+The conformation tensor is initialised at its equilibrium value
+$\mathbf{A} = L^2/(L^2 + 3)\,\mathbf{I}$, for which the stress vanishes.
+The relaxation step is described in
+[log-conform-viscoelastic-scalar-3D.h](log-conform-viscoelastic-scalar-3D.h#fene-p).
+*/
+
+#define FENE_P 1
+#include "log-conform-viscoelastic-scalar-3D.h"
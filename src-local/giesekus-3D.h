@@ -0,0 +1,33 @@
+/** Title: giesekus-3D.h
+# Version: 1.0
+# Main feature: Giesekus model for the 3D scalar log-conformation solver.
+
+# Author: Vatsal Sanjay
+# vatsalsanjay@gmail.com
+# Physics of Fluids
+# Updated: Oct 18, 2026
+
+# change log: Oct 18, 2026 (v1.0)
+- First version.
+
+# Usage
+Include this file instead of
+[log-conform-viscoelastic-scalar-3D.h](log-conform-viscoelastic-scalar-3D.h)
+and set the mobility factor *alphaG* ($0 \leq \alpha_G \leq 1$, default 0,
+i.e. Oldroyd-B) in *main()*
+
+~~~literatec
+#include "../src-local/giesekus-3D.h"
+...
+int main() {
+  alphaG = 0.2;
+  ...
+}
+~~~
+
+The relaxation step is described in
+[log-conform-viscoelastic-scalar-3D.h](log-conform-viscoelastic-scalar-3D.h#giesekus).
+*/
+
+#define GIESEKUS 1
+#include "log-conform-viscoelastic-scalar-3D.h"
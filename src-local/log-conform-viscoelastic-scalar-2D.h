@@ -1,12 +1,12 @@
 /** Title: log-conform-viscoelastic-scalar-2D.h
-# Version: 2.5
+# Version: 2.6
 # Main feature 1: A exists in across the domain and relaxes according to \lambda. The stress only acts according to G.
 # Main feature 2: This is the 2D+axi **scalar** implementation of [log-conform-viscoelastic.h](log-conform-viscoelastic.h).
 
 # Author: Vatsal Sanjay
 # vatsalsanjay@gmail.com
 # Physics of Fluids
-# Updated: Nov 23, 2024
+# Updated: Oct 18, 2026
 
 # change log: Oct 18, 2024 (v1.0)
 - 2D+axi implementation
@@ -30,6 +30,9 @@ Other under the hood changes:
 # change log: Nov 23, 2024 (v2.5)
 - improved documentation.
 
+# change log: Oct 18, 2026 (v2.6)
+- with *lean_step* (see [centered.h](../basilisk/src/navier-stokes/centered.h)), the face velocity is built in the same sweep as the divergence of the stress.
+
 # TODO: (non-critical, non-urgent)
  * Ideally, we would like to consistently use tensor formulation to leverage ease of readability and maintainability. Also, tensors will be more efficient and would avoid bugs. It is also a prerequisite for axi compatibility of the 3D version of this code: [log-conform-viscoelastic-scalar-3D.h](log-conform-viscoelastic-scalar-3D.h). See: https://github.com/comphy-lab/Viscoelastic3D/issues/11 and https://github.com/comphy-lab/Viscoelastic3D/issues/5. 
  * - [ ] enfore all tensors and make the code generally compatible using foreach_dimensions
@@ -544,11 +547,16 @@ calculated directly from center values of cells sharing the face. The
 other one is harder. It will be computed from vertex values. The
 vertex values are obtained by averaging centered values.  Note that as
 a result of the vertex averaging cells `[]` and `[-1,0]` are not
-involved in the computation of shear. */
+involved in the computation of shear.
+
+With *lean_step*, if this is the last term added to the acceleration,
+the face velocity field is built in the same sweeps (see
+[centered.h](../basilisk/src/navier-stokes/centered.h)). */
 
 event acceleration (i++)
 {
   face vector av = a;
+  bool fuse = uf_fusable (_ev);
 
   foreach_face(x){
     if (fm.x[] > 1e-20) {
@@ -560,6 +568,8 @@ event acceleration (i++)
       alpha.x[]/(sq(fm.x[])*Delta);
     
     }
+    if (fuse)
+      uf.x[] = face_velocity_x (point);
   }
 
   foreach_face(y){
@@ -572,11 +582,19 @@ event acceleration (i++)
       alpha.y[]/(sq(fm.y[])*Delta);
 
     }
+#if !AXI
+    if (fuse)
+      uf.y[] = face_velocity_y (point);
+#endif
   }
 
 #if AXI
-  foreach_face(y)
+  foreach_face(y) {
     if (y > 1e-20)
       av.y[] -= (T_ThTh[] + T_ThTh[0,-1])*alpha.y[]/sq(y)/2.;
+    if (fuse)
+      uf.y[] = face_velocity_y (point);
+  }
 #endif
+  uf_built = fuse;
 }
@@ -1,12 +1,12 @@
 /** Title: log-conform-viscoelastic-3D.h
-# Version: 2.5
+# Version: 2.13
 # Main feature 1: A exists in across the domain and relaxes according to \lambda. The stress only acts according to G.
 # Main feature 2: This is the 3D implementation of [log-conform-viscoelastic-scalar-2D.h](log-conform-viscoelastic-scalar-2D.h).
 
 # Author: Vatsal Sanjay
 # vatsalsanjay@gmail.com
 # Physics of Fluids
-# Updated: Nov 23, 2024
+# Updated: Oct 18, 2026
 
 # change log: Oct 19, 2024 (v1.0)
 - 3D implementation
@@ -48,6 +48,30 @@
 # change log: Nov 23, 2024 (v2.5)
 - improved documentation.
 
+# change log: Oct 18, 2026 (v2.6)
+- optional both-sides diffusion (BSD) stabilisation, see *betaBSD*. An artificial polymeric viscosity is added implicitly through the viscous solve of [viscosity.h](http://basilisk.fr/src/viscosity.h) and subtracted explicitly.
+
+# change log: Oct 18, 2026 (v2.7)
+- FENE-P and Giesekus models, selected at compile time ([fene-p-3D.h](fene-p-3D.h), [giesekus-3D.h](giesekus-3D.h)). The relaxation step is solved per eigenvalue in the eigenbasis of $\Psi$.
+
+# change log: Oct 18, 2026 (v2.8)
+- optional (*logAdapt*): the six components of $\mathbf{A}$ are refined and coarsened together in log space on trees. Refined and coarsened cells stay positive definite.
+
+# change log: Oct 18, 2026 (v2.9)
+- optional quasi-steady fast path for low local Weissenberg numbers, see *WiFast*. These cells use the linearised closure $\mathbf{T} = 2G_p\lambda\mathbf{D}$ without eigen-decomposition.
+
+# change log: Oct 18, 2026 (v2.10)
+- with *lean_step* (see [centered.h](../basilisk/src/navier-stokes/centered.h)), the face velocity is built in the same sweep as the divergence of the stress.
+
+# change log: Oct 18, 2026 (v2.11)
+- optional local time stepping of the constitutive update on octrees, see *ltsLevels*. Coarse cells apply the upper convective and relaxation terms every $2^k$ timesteps; the advection of $\Psi$ stays global. Cells where this interval exceeds *ltsCFL*$/\|\nabla\mathbf{u}\|$ are updated earlier, and in cells which skipped timesteps a rotation rate $\Omega$ beyond *ltsCFL* over the interval falls back to the degenerate form.
+
+# change log: Oct 18, 2026 (v2.12)
+- the diagonalization loops use a dynamic OpenMP schedule (`foreach (dynamic)`): their cost per cell varies by about 10x between diagonal and full conformation tensors, and with the quasi-steady and local time stepping options.
+
+# change log: Oct 18, 2026 (v2.13)
+- optional implicit diffusion of $\Psi$, see *psiDiffusion*. The diffusivity scales with the square of the local grid size; the six components are solved together by the multigrid solver.
+
 # TODO: (non-critical, non-urgent)
  * axi compatibility is not there. This will not be fixed. To use axi, please use: [log-conform-viscoelastic-scalar-2D.h](log-conform-viscoelastic-scalar-2D.h) for a scalar formulation, or better yet, use [log-conform-viscoelastic.h](log-conform-viscoelastic.h) which is more efficient.
  * I have (wherever I could) used the metric terms: cm and fm. Of course, that alone does not guarentee axi compatibility. Proposed steps to do: 
@@ -194,6 +218,27 @@ TODO:
 (const) scalar Gp = unity; // elastic modulus
 (const) scalar lambda = unity; // relaxation time
 
+/*
+both-sides diffusion (BSD) stabilisation: ratio between the artificial and the effective polymeric viscosity. 0 switches it off. */
+double betaBSD = 0.;
+
+/*
+parameters of the nonlinear constitutive models, see [fene-p-3D.h](fene-p-3D.h) and [giesekus-3D.h](giesekus-3D.h). A_EQUILIBRIUM is the diagonal of the conformation tensor at rest. */
+#if FENE_P || GIESEKUS
+#if dimension != 3
+#error "the FENE-P and Giesekus models are only implemented in 3D"
+#endif
+#endif
+#if FENE_P
+double L2 = 100.; // square of the maximum extensibility of the polymer chains
+#define A_EQUILIBRIUM (L2/(L2 + 3.))
+#elif GIESEKUS
+double alphaG = 0.; // Giesekus mobility factor
+#endif
+#ifndef A_EQUILIBRIUM
+#define A_EQUILIBRIUM 1.
+#endif
+
 /*
 conformation tensor */
 // diagonal elements
@@ -216,7 +261,7 @@ event defaults (i = 0) {
   */
   for (scalar s in {A11, A22, A33}) {
     foreach () {
-      s[] = 1.;
+      s[] = A_EQUILIBRIUM;
     }
   }
   for (scalar s in {T11, T12, T13, T22, T23, T33, A12, A13, A23}) {
@@ -361,8 +406,533 @@ static void diagonalization_3D (pseudo_v3d * Lambda, pseudo_t3d * R, pseudo_t3d
   R->z.x = eigenvectors[2][0]; R->z.y = eigenvectors[2][1]; R->z.z = eigenvectors[2][2];
 
 }
+
+/**
+## Nonlinear constitutive models (3D)
+
+The default model is Oldroyd-B. FENE-P and Giesekus are selected at
+compile time, by including [fene-p-3D.h](fene-p-3D.h) or
+[giesekus-3D.h](giesekus-3D.h) instead of this file (or by defining
+*FENE_P* or *GIESEKUS* before including it).
+
+For both models, $\mathbf{f}_r(\mathbf{A})$ is an isotropic function
+of $\mathbf{A}$: it shares its eigenvectors. The relaxation step c)
+below is therefore solved in the eigenbasis already computed to
+exponentiate $\Psi$, one eigenvalue $a_i$ at a time, and $\mathbf{A}$
+is rebuilt afterwards. *relax_eigenvalues()* updates the eigenvalues
+over $k = \Delta t/\lambda$ and returns the factor $\nu$ of the stress
+$\mathbf{T} = G_p(\nu\mathbf{A} - \mathbf{I})$. The kernel is a plain
+inline function so that nothing is dispatched at runtime in the loop
+over the cells. */
+
+#if FENE_P
+
+/**
+### FENE-P
+
+$\mathbf{f}_s(\mathbf{A}) = \mathbf{f}_r(\mathbf{A}) = \nu\mathbf{A} -
+\mathbf{I}$ with $\nu = 1/(1 - \mathrm{tr}\,\mathbf{A}/L^2)$, as in
+[fene-p.h](http://basilisk.fr/src/fene-p.h). The eigenvalues only
+couple through the trace. A backward Euler step for the trace is a
+quadratic equation for $s = \mathrm{tr}\,\mathbf{A}^{n+1}$
+$$
+s^2 - [L^2(1 + k) + S]\,s + S L^2 = 0, \quad S = \mathrm{tr}\,\mathbf{A}^n + 3k
+$$
+whose smallest root always lies in $]0,L^2[$. With $\nu$ frozen at
+this value, each eigenvalue is then integrated exactly
+$$
+a_i^{n+1} = \frac{1}{\nu} + \left(a_i^n - \frac{1}{\nu}\right)e^{-k\nu}
+$$
+which stays positive, keeps the trace below $L^2$ and reduces to the
+Oldroyd-B update when $L^2 \rightarrow \infty$. */
+
+static inline double relax_eigenvalues (pseudo_v3d * a, double dt, double lambda)
+{
+  double nu;
+  if (lambda == 0.) {
+    a->x = a->y = a->z = A_EQUILIBRIUM;
+    nu = 1./A_EQUILIBRIUM;
+  }
+  else {
+    double k = dt/lambda, S = a->x + a->y + a->z + 3.*k;
+    double b = L2*(1. + k) + S;
+    double s = 2.*S*L2/(b + sqrt(sq(b) - 4.*S*L2));
+    nu = L2/(L2 - s);
+    double fa = exp(-k*nu);
+    a->x = (1. - fa)/nu + a->x*fa;
+    a->y = (1. - fa)/nu + a->y*fa;
+    a->z = (1. - fa)/nu + a->z*fa;
+  }
+  // stress factor at the new trace
+  return 1./(1. - (a->x + a->y + a->z)/L2);
+}
+
+#elif GIESEKUS
+
+/**
+### Giesekus
+
+$\mathbf{f}_s(\mathbf{A}) = \mathbf{A} - \mathbf{I}$ and
+$\mathbf{f}_r(\mathbf{A}) = \mathbf{A} - \mathbf{I} + \alpha_G(\mathbf{A} -
+\mathbf{I})^2$ with the mobility factor $0 \leq \alpha_G \leq 1$. The
+eigenvalues are decoupled and $b_i = a_i - 1$ follows a Bernoulli
+equation with the exact solution
+$$
+b_i^{n+1} = \frac{b_i^n e^{-k}}{1 + \alpha_G b_i^n (1 - e^{-k})}
+$$
+The denominator is positive whenever $a_i^n > 0$, so that
+$\mathbf{A}$ stays positive definite for any timestep. $\alpha_G = 0$
+is the Oldroyd-B update. */
+
+static inline double relax_eigenvalues (pseudo_v3d * a, double dt, double lambda)
+{
+  double fa = lambda != 0. ? exp(-dt/lambda) : 0.;
+  a->x = 1. + (a->x - 1.)*fa/(1. + alphaG*(a->x - 1.)*(1. - fa));
+  a->y = 1. + (a->y - 1.)*fa/(1. + alphaG*(a->y - 1.)*(1. - fa));
+  a->z = 1. + (a->z - 1.)*fa/(1. + alphaG*(a->z - 1.)*(1. - fa));
+  return 1.;
+}
+
+#endif // GIESEKUS
 #endif
 
+/**
+## Adaptivity of the conformation tensor
+
+By default, each component of $\mathbf{A}$ is refined and coarsened
+on its own. With *logAdapt = true*, the six components are refined
+and coarsened together, in log space: $\Psi = \log\mathbf{A}$ is computed on the
+coarse stencil (resp. on the children), interpolated bilinearly
+(resp. averaged) and exponentiated. The new values are symmetric
+positive definite whatever the stress gradients, so that
+*adapt_wavelet()* can coarsen the low-stress polymer regions. This
+costs eigen-decompositions in each refined or coarsened cell and
+changes the values of the new cells, hence the adapted meshes, so it
+is opt-in.
+
+These operators assume that the fields hold $\mathbf{A}$, i.e. that
+the mesh is not adapted during *tracer_advection*. */
+
+#if dimension == 3 && TREE
+bool logAdapt = false;
+
+/**
+*conformation_function()* replaces the packed tensor *a* (11, 22, 33,
+12, 13, 23) with its logarithm or its exponential. The logarithm
+fails if *a* is not positive definite. */
+
+static bool conformation_function (double a[6], bool logarithm)
+{
+  pseudo_t3d A, R;
+  pseudo_v3d Lambda;
+  A.x.x = a[0]; A.y.y = a[1]; A.z.z = a[2];
+  A.x.y = A.y.x = a[3]; A.x.z = A.z.x = a[4]; A.y.z = A.z.y = a[5];
+  diagonalization_3D (&Lambda, &R, &A);
+  if (logarithm) {
+    if (Lambda.x <= 0. || Lambda.y <= 0. || Lambda.z <= 0.)
+      return false;
+    Lambda.x = log(Lambda.x); Lambda.y = log(Lambda.y); Lambda.z = log(Lambda.z);
+  }
+  else {
+    Lambda.x = exp(Lambda.x); Lambda.y = exp(Lambda.y); Lambda.z = exp(Lambda.z);
+  }
+  a[0] = Lambda.x*sq(R.x.x) + Lambda.y*sq(R.x.y) + Lambda.z*sq(R.x.z);
+  a[1] = Lambda.x*sq(R.y.x) + Lambda.y*sq(R.y.y) + Lambda.z*sq(R.y.z);
+  a[2] = Lambda.x*sq(R.z.x) + Lambda.y*sq(R.z.y) + Lambda.z*sq(R.z.z);
+  a[3] = Lambda.x*R.x.x*R.y.x + Lambda.y*R.x.y*R.y.y + Lambda.z*R.x.z*R.y.z;
+  a[4] = Lambda.x*R.x.x*R.z.x + Lambda.y*R.x.y*R.z.y + Lambda.z*R.x.z*R.z.z;
+  a[5] = Lambda.x*R.y.x*R.z.x + Lambda.y*R.y.y*R.z.y + Lambda.z*R.y.z*R.z.z;
+  return true;
+}
+
+/**
+The refine and coarsen methods are called once per component, for
+the same cell. The first call computes the whole tensor and the five
+following calls only copy the result. */
+
+typedef struct {
+  int level, i, j, k;
+  unsigned done;
+  double a[6];
+} ConformationCache;
+
+static bool conformation_cached (Point point, scalar s, ConformationCache * c)
+{
+  int n = 0;
+  for (scalar t in {A11, A22, A33, A12, A13, A23}) {
+    if (t.i == s.i)
+      break;
+    n++;
+  }
+  unsigned bit = 1 << n;
+  if (c->level == level && c->i == point.i && c->j == point.j &&
+      c->k == point.k && !(c->done & bit)) {
+    c->done |= bit;
+    return true;
+  }
+  c->level = level, c->i = point.i, c->j = point.j, c->k = point.k;
+  c->done = bit;
+  return false;
+}
+
+static void refine_conformation (Point point, scalar s)
+{
+  static ConformationCache cache = {-1};
+  if (conformation_cached (point, s, &cache))
+    return;
+
+  /**
+  $\Psi$ on the $3^3$ coarse stencil. Neighbours which are not
+  positive definite (e.g. undefined boundary values) are replaced
+  with the parent. */
+
+  double psi[3][3][3][6];
+  int n = 0;
+  for (scalar t in {A11, A22, A33, A12, A13, A23})
+    psi[1][1][1][n++] = t[];
+  if (!conformation_function (psi[1][1][1], true)) {
+    for (scalar t in {A11, A22, A33, A12, A13, A23})
+      refine_bilinear (point, t);
+    return;
+  }
+  for (int i = -1; i <= 1; i++)
+    for (int j = -1; j <= 1; j++)
+      for (int k = -1; k <= 1; k++)
+	if (i || j || k) {
+	  double * a = psi[i + 1][j + 1][k + 1];
+	  n = 0;
+	  for (scalar t in {A11, A22, A33, A12, A13, A23})
+	    a[n++] = t[i,j,k];
+	  if (!conformation_function (a, true))
+	    for (n = 0; n < 6; n++)
+	      a[n] = psi[1][1][1][n];
+	}
+
+  foreach_child() {
+    int x = child.x + 1, y = child.y + 1, z = child.z + 1;
+    double a[6];
+    for (n = 0; n < 6; n++)
+      a[n] = (27.*psi[1][1][1][n] +
+	      9.*(psi[x][1][1][n] + psi[1][y][1][n] + psi[1][1][z][n]) +
+	      3.*(psi[x][y][1][n] + psi[x][1][z][n] + psi[1][y][z][n]) +
+	      psi[x][y][z][n])/64.;
+    conformation_function (a, false);
+    n = 0;
+    for (scalar t in {A11, A22, A33, A12, A13, A23})
+      t[] = a[n++];
+  }
+}
+
+/**
+When coarsening, the restriction of each component (a volume
+average) is called first and then overwritten with the log-Euclidean
+mean of the children. */
+
+static void coarsen_conformation (Point point, scalar s)
+{
+  static ConformationCache cache = {-1};
+  if (!conformation_cached (point, s, &cache)) {
+    for (int n = 0; n < 6; n++)
+      cache.a[n] = 0.;
+    bool spd = true;
+    foreach_child() {
+      double a[6];
+      int n = 0;
+      for (scalar t in {A11, A22, A33, A12, A13, A23})
+	a[n++] = t[];
+      spd = spd && conformation_function (a, true);
+      for (n = 0; n < 6; n++)
+	cache.a[n] += a[n]/(1 << dimension);
+    }
+    if (spd)
+      conformation_function (cache.a, false);
+    else { // plain volume average
+      int n = 0;
+      for (scalar t in {A11, A22, A33, A12, A13, A23}) {
+	restriction_average (point, t);
+	cache.a[n++] = t[];
+      }
+    }
+  }
+  int n = 0;
+  for (scalar t in {A11, A22, A33, A12, A13, A23}) {
+    if (t.i == s.i)
+      s[] = cache.a[n];
+    n++;
+  }
+}
+
+event defaults (i = 0) {
+  if (logAdapt)
+    for (scalar s in {A11, A22, A33, A12, A13, A23}) {
+      s.refine = refine_conformation;
+      s.coarsen = coarsen_conformation;
+    }
+}
+#endif // dimension == 3 && TREE
+
+#if dimension == 3
+/**
+## Quasi-steady fast path (3D)
+
+Where the local Weissenberg number $Wi = \lambda|\nabla\mathbf{u}|$ is
+small, $\mathbf{A}$ is slaved to the velocity gradient. To first order
+in $Wi$ (retarded-motion expansion), for the three models
+$$
+\mathbf{A} = a_e(\mathbf{I} + 2\lambda a_e\mathbf{D}), \quad
+\mathbf{T} = 2G_p\lambda a_e\mathbf{D}
+$$
+with $\mathbf{D}$ the rate of strain and $a_e$ the equilibrium value
+*A_EQUILIBRIUM* (one except for FENE-P). With *WiFast > 0*, a cell
+enters this regime when $Wi <$ *WiFast* and its $\mathbf{A}$ already
+matches the closure within a fraction *WiFast* of the closure stress
+$$
+\|\mathbf{A} - \mathbf{A}_c\| \leq WiFast\,\|\mathbf{A}_c - a_e\mathbf{I}\|
+$$
+so that the stress of relaxing regions is not discarded. It goes back
+to the log-conformation update as soon as $Wi > 2$*WiFast*. Within
+the regime, nothing is diagonalised: $\Psi$, which is still needed to
+advect the neighbouring cells, is given by a truncated series.
+*quasiSteady* is one in these cells.
+
+The closure neglects $\lambda\partial_t\mathbf{A}$. Both tests are
+relative to the polymer stress: an absolute threshold is met by any
+cell at low strain, whatever its memory. The error of the closure is
+not bounded a priori and should be checked against runs without
+*WiFast* (see [costAccuracy.sh](../testCases/costAccuracy.sh)). */
+
+double WiFast = 0.;
+(const) scalar quasiSteady = zeroc;
+
+event defaults (i = 0) {
+  if (WiFast > 0. && is_constant (quasiSteady)) {
+    quasiSteady = new scalar;
+    foreach()
+      quasiSteady[] = 0.;
+#if TREE
+    quasiSteady.refine = refine_injection;
+#endif
+  }
+}
+
+/**
+*velocity_gradient()* fills $G_{ij} = \partial_j u_i$ and returns its
+norm. */
+
+static inline double velocity_gradient (Point point, pseudo_t3d * G)
+{
+  G->x.x = (u.x[1,0,0] - u.x[-1,0,0])/(2.*Delta);
+  G->x.y = (u.x[0,1,0] - u.x[0,-1,0])/(2.*Delta);
+  G->x.z = (u.x[0,0,1] - u.x[0,0,-1])/(2.*Delta);
+  G->y.x = (u.y[1,0,0] - u.y[-1,0,0])/(2.*Delta);
+  G->y.y = (u.y[0,1,0] - u.y[0,-1,0])/(2.*Delta);
+  G->y.z = (u.y[0,0,1] - u.y[0,0,-1])/(2.*Delta);
+  G->z.x = (u.z[1,0,0] - u.z[-1,0,0])/(2.*Delta);
+  G->z.y = (u.z[0,1,0] - u.z[0,-1,0])/(2.*Delta);
+  G->z.z = (u.z[0,0,1] - u.z[0,0,-1])/(2.*Delta);
+  return sqrt (sq(G->x.x) + sq(G->x.y) + sq(G->x.z) +
+	       sq(G->y.x) + sq(G->y.y) + sq(G->y.z) +
+	       sq(G->z.x) + sq(G->z.y) + sq(G->z.z));
+}
+
+static void quasi_steady_conformation (pseudo_t3d * G, double lambda,
+				       pseudo_t3d * A)
+{
+  double ae = A_EQUILIBRIUM, c = lambda*sq(ae);
+  A->x.x = ae + 2.*c*G->x.x;
+  A->y.y = ae + 2.*c*G->y.y;
+  A->z.z = ae + 2.*c*G->z.z;
+  A->x.y = A->y.x = c*(G->x.y + G->y.x);
+  A->x.z = A->z.x = c*(G->x.z + G->z.x);
+  A->y.z = A->z.y = c*(G->y.z + G->z.y);
+}
+
+/**
+*quasi_steady()* updates the regime of the cell, with hysteresis. In
+the regime, $\mathbf{A}$ holds the closure of the previous timestep
+and the neglected memory term must stay small compared to the stress,
+$\lambda\|\partial_t\mathbf{A}\| \leq WiFast\,\|\mathbf{A} -
+a_e\mathbf{I}\|$. */
+
+static void quasi_steady (Point point)
+{
+  pseudo_t3d G, A;
+  double Wi = lambda[]*velocity_gradient (point, &G);
+  if (Wi > 2.*WiFast || (!quasiSteady[] && Wi >= WiFast)) {
+    quasiSteady[] = 0.;
+    return;
+  }
+  quasi_steady_conformation (&G, lambda[], &A);
+  double ae = A_EQUILIBRIUM;
+  double e = sqrt (sq(A11[] - A.x.x) + sq(A22[] - A.y.y) + sq(A33[] - A.z.z) +
+		   2.*(sq(A12[] - A.x.y) + sq(A13[] - A.x.z) + sq(A23[] - A.y.z)));
+  if (quasiSteady[]) {
+    double s = sqrt (sq(A11[] - ae) + sq(A22[] - ae) + sq(A33[] - ae) +
+		     2.*(sq(A12[]) + sq(A13[]) + sq(A23[])));
+    quasiSteady[] = lambda[]*e/dt <= WiFast*s;
+  }
+  else {
+    double s = sqrt (sq(A.x.x - ae) + sq(A.y.y - ae) + sq(A.z.z - ae) +
+		     2.*(sq(A.x.y) + sq(A.x.z) + sq(A.y.z)));
+    quasiSteady[] = e <= WiFast*s;
+  }
+}
+
+/**
+$\log\mathbf{A} = \log(a_e)\mathbf{I} + \mathbf{E} - \mathbf{E}^2/2 +
+\mathbf{E}^3/3 + O(Wi^4)$ with $\mathbf{E} = \mathbf{A}/a_e - \mathbf{I}$. */
+
+static void log_near_equilibrium (pseudo_t3d * A)
+{
+  double ae = A_EQUILIBRIUM;
+  double E[3][3] = {{A->x.x/ae - 1., A->x.y/ae, A->x.z/ae},
+		    {A->y.x/ae, A->y.y/ae - 1., A->y.z/ae},
+		    {A->z.x/ae, A->z.y/ae, A->z.z/ae - 1.}};
+  double E2[3][3], P[3][3];
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 3; j++) {
+      E2[i][j] = 0.;
+      for (int k = 0; k < 3; k++)
+	E2[i][j] += E[i][k]*E[k][j];
+    }
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 3; j++) {
+      double E3 = 0.;
+      for (int k = 0; k < 3; k++)
+	E3 += E2[i][k]*E[k][j];
+      P[i][j] = (i == j ? log(ae) : 0.) + E[i][j] - E2[i][j]/2. + E3/3.;
+    }
+  A->x.x = P[0][0]; A->x.y = P[0][1]; A->x.z = P[0][2];
+  A->y.x = P[1][0]; A->y.y = P[1][1]; A->y.z = P[1][2];
+  A->z.x = P[2][0]; A->z.y = P[2][1]; A->z.z = P[2][2];
+}
+#endif // dimension == 3
+
+/**
+## Implicit diffusion of $\Psi$ (optional)
+
+Under-resolved polymer regions produce steep, noisy $\Psi$ fields.
+Rather than refining them to *MAXlevel*, a small isotropic diffusion
+can be added to the transport of $\Psi$,
+$$
+\partial_t \Psi + \nabla\cdot(\Psi\mathbf{u}) = \nabla\cdot(\kappa\nabla\Psi),
+\qquad \kappa = \kappa_\Delta\Delta^2
+$$
+with $\Delta$ the local (face) grid size, so that the diffusion
+vanishes at second order with refinement and is strongest where the
+grid is coarse. $\kappa_\Delta$, in units of an inverse time, is set
+with *psiDiffusion* (0 switches it off).
+
+After advection, each component solves the Helmholtz problem of
+[diffusion.h](http://basilisk.fr/src/diffusion.h) (backward Euler).
+The components share $\kappa$ and the diagonal term, so they are
+solved as one list by the multigrid solver of
+[poisson.h](http://basilisk.fr/src/poisson.h): each relaxation and
+residual sweep updates all of them in a single traversal of the
+hierarchy. The statistics of the last solve are in *mgPsi*. The range
+of $\kappa$ over the grid at the first timestep is written on the log
+and kept in *psiKappaMin*, *psiKappaMax* (it is not updated when the
+grid is adapted, to avoid a global reduction at every timestep). */
+
+double psiDiffusion = 0.;
+mgstats mgPsi;
+double psiKappaMin = 0., psiKappaMax = 0.;
+
+struct PsiDiffusion {
+  face vector kappa;
+  double idt;
+  vector * gl; // fluxes, one per component
+};
+
+static void relax_psi (scalar * al, scalar * bl, int l, void * data)
+{
+  struct PsiDiffusion * p = (struct PsiDiffusion *) data;
+  face vector kappa = p->kappa;
+  foreach_level_or_leaf (l) {
+    double d = p->idt*cm[]*sq(Delta);
+    foreach_dimension()
+      d += kappa.x[1] + kappa.x[];
+    scalar a, b;
+    for (a, b in al, bl) {
+      double n = - sq(Delta)*b[];
+      foreach_dimension()
+	n += kappa.x[1]*a[1] + kappa.x[]*a[-1];
+      a[] = n/d;
+    }
+  }
+}
+
+static double residual_psi (scalar * al, scalar * bl, scalar * resl, void * data)
+{
+  struct PsiDiffusion * p = (struct PsiDiffusion *) data;
+  face vector kappa = p->kappa;
+  vector * gl = p->gl;
+  double maxres = 0.;
+  foreach_face() {
+    scalar a;
+    vector g;
+    for (a, g in al, gl)
+      g.x[] = kappa.x[]*face_gradient_x (a, 0);
+  }
+  foreach (reduction(max:maxres), nowarning) {
+    scalar a, b, res;
+    vector g;
+    for (a, b, res, g in al, bl, resl, gl) {
+      res[] = b[] + p->idt*cm[]*a[];
+      foreach_dimension()
+	res[] -= (g.x[1] - g.x[])/Delta;
+      if (fabs (res[]) > maxres)
+	maxres = fabs (res[]);
+    }
+  }
+  return maxres;
+}
+
+/**
+*psi_diffusion()* diffuses the components of $\Psi$ in *list* over
+the timestep. */
+
+trace
+static void psi_diffusion (scalar * list)
+{
+  if (psiDiffusion <= 0.)
+    return;
+  face vector kappa[];
+  foreach_face()
+    kappa.x[] = fm.x[]*psiDiffusion*sq(Delta);
+  restriction ((scalar *){kappa});
+
+  scalar * rhs = list_clone (list);
+  scalar a, b;
+  for (a, b in list, rhs)
+    foreach()
+      b[] = - cm[]*a[]/dt;
+
+  vector * gl = NULL;
+  for (int k = 0; k < list_len (list); k++) {
+    vector g = new face vector;
+    gl = vectors_append (gl, g);
+  }
+  struct PsiDiffusion p = {kappa, 1./dt, gl};
+  mgPsi = mg_solve (list, rhs, residual_psi, relax_psi, &p);
+  delete (rhs), free (rhs);
+  for (vector g in gl)
+    delete ((scalar *){g});
+  free (gl);
+
+  if (iter == 0) {
+    double kmin = HUGE, kmax = 0.;
+    foreach (reduction(min:kmin) reduction(max:kmax)) {
+      double k = psiDiffusion*sq(Delta);
+      if (k < kmin) kmin = k;
+      if (k > kmax) kmax = k;
+    }
+    psiKappaMin = kmin, psiKappaMax = kmax;
+    fprintf (ferr, "psiDiffusion: kappa = %g to %g (Delta = %g to %g)\n",
+	     kmin, kmax, sqrt(kmin/psiDiffusion), sqrt(kmax/psiDiffusion));
+  }
+}
+
 /**
 The stress tensor depends on previous instants and has to be
 integrated in time. In the log-conformation scheme the advection of
@@ -398,7 +968,7 @@ event tracer_advection(i++)
   /**
   ### Computation of $\Psi = \log \mathbf{A}$ and upper convective term */
 
-  foreach() {
+  foreach (dynamic) {
     /**
       We assume that the stress tensor $\mathbf{\tau}_p$ depends on the
       conformation tensor $\mathbf{A}$ as follows
@@ -521,11 +1091,12 @@ event tracer_advection(i++)
   conformation tensor $\Psi$. */
 
   advection ({Psi11, Psi12, Psi22}, uf, dt);
+  psi_diffusion ({Psi11, Psi12, Psi22});
 
   /**
   ### Convert back to Aij */
 
-  foreach() {
+  foreach (dynamic) {
     /**
     It is time to undo the log-conformation, again by
     diagonalization, to recover the conformation tensor $\mathbf{A}$
@@ -574,6 +1145,458 @@ event tracer_advection(i++)
 
 #elif dimension == 3
 
+/**
+*upper_convected_3D()* computes the tensors $\mathbf{B}$ and $\Omega$
+of the decomposition of the velocity gradient, given the eigenvalues
+*Lambda* and eigenvectors *R* of $\mathbf{A}$. Eigenvalues closer than
+*tolerance* are treated as equal. */
+
+static void upper_convected_3D (Point point, pseudo_v3d * Lambda, pseudo_t3d * R,
+				pseudo_t3d * B, pseudo_t3d * Omega, double tolerance)
+{
+  pseudo_t3d M;
+  init_pseudo_t3d(B, 0.0);
+  init_pseudo_t3d(&M, 0.0);
+  init_pseudo_t3d(Omega, 0.0);
+
+  // Check if any pair of eigenvalues are numerically equal (within a small tolerance)
+  if (fabs(Lambda->x - Lambda->y) <= tolerance || fabs(Lambda->y - Lambda->z) <= tolerance || fabs(Lambda->z - Lambda->x) <= tolerance) {
+    // In case of equal eigenvalues, the calculations for B and Omega simplify significantly
+    // B is grad U and Omega is zero.
+
+    // Compute off-diagonal elements of B using central differences
+    // These represent the symmetric part of the velocity gradient tensor
+    B->x.y = (u.y[1,0,0] - u.y[-1,0,0] + u.x[0,1,0] - u.x[0,-1,0])/(4.*Delta);  // (dv/dx + du/dy)/2
+    B->x.z = (u.z[1,0,0] - u.z[-1,0,0] + u.x[0,0,1] - u.x[0,0,-1])/(4.*Delta);  // (dw/dx + du/dz)/2
+    B->y.z = (u.z[0,1,0] - u.z[0,-1,0] + u.y[0,0,1] - u.y[0,0,-1])/(4.*Delta);  // (dw/dy + dv/dz)/2
+
+    // Compute diagonal elements of B
+    // These represent the normal strain rates
+    B->x.x = (u.x[1,0,0] - u.x[-1,0,0])/(2.*Delta);  // du/dx
+    B->y.y = (u.y[0,1,0] - u.y[0,-1,0])/(2.*Delta);  // dv/dy
+    B->z.z = (u.z[0,0,1] - u.z[0,0,-1])/(2.*Delta);  // dw/dz
+
+    // Set all components of Omega to zero
+    // This is because Omega represents the antisymmetric part of the velocity gradient tensor,
+    // which vanishes when eigenvalues are equal
+    Omega->x.y = Omega->x.z = Omega->y.z = Omega->y.x = Omega->z.x = Omega->z.y = 0.;
+
+  } else {
+    
+    /*
+    ### Compute the velocity gradient tensor components using central differences
+    - These represent the spatial derivatives of each velocity component
+    - These gradients form the velocity gradient tensor (nablaU):
+    [ dudx  dudy  dudz ]
+    [ dvdx  dvdy  dvdz ]
+    [ dwdx  dwdy  dwdz ]
+    */
+
+    // Derivatives of u (x-component of velocity)
+    double dudx = (u.x[1,0,0] - u.x[-1,0,0])/(2.0*Delta);  // du/dx
+    double dudy = (u.x[0,1,0] - u.x[0,-1,0])/(2.0*Delta);  // du/dy
+    double dudz = (u.x[0,0,1] - u.x[0,0,-1])/(2.0*Delta);  // du/dz
+
+    // Derivatives of v (y-component of velocity)
+    double dvdx = (u.y[1,0,0] - u.y[-1,0,0])/(2.0*Delta);  // dv/dx
+    double dvdy = (u.y[0,1,0] - u.y[0,-1,0])/(2.0*Delta);  // dv/dy
+    double dvdz = (u.y[0,0,1] - u.y[0,0,-1])/(2.0*Delta);  // dv/dz
+
+    // Derivatives of w (z-component of velocity)
+    double dwdx = (u.z[1,0,0] - u.z[-1,0,0])/(2.0*Delta);  // dw/dx
+    double dwdy = (u.z[0,1,0] - u.z[0,-1,0])/(2.0*Delta);  // dw/dy
+    double dwdz = (u.z[0,0,1] - u.z[0,0,-1])/(2.0*Delta);  // dw/dz
+
+    /*
+    Calculate the M tensor through matrix multiplication: M = R * (nablaU)^T R^T. This represents the velocity gradient tensor transformed to the eigenvector basis of the conformation tensor.
+    
+    * Steps:
+    1. Compute intermediate products (R * nablaU^T):
+       - Store row-wise products in Rx_gradU_*, Ry_gradU_*, Rz_gradU_*
+       - Each variable represents one row of the intermediate matrix
+    2. Multiply by R^T to obtain the final M tensor:
+       - M.i.j represents the (i,j) component of the transformed velocity gradient
+       - This transformation expresses the velocity gradient in the eigenvector basis
+       - The resulting M tensor is used to compute Omega (Ω) and B tensors, such that 
+    */
+
+    // First, compute intermediate products of R and (nablaU)^T
+    double Rx_gradU_x = R->x.x*dudx + R->x.y*dvdx + R->x.z*dwdx;
+    double Rx_gradU_y = R->x.x*dudy + R->x.y*dvdy + R->x.z*dwdy;
+    double Rx_gradU_z = R->x.x*dudz + R->x.y*dvdz + R->x.z*dwdz;
+
+    double Ry_gradU_x = R->y.x*dudx + R->y.y*dvdx + R->y.z*dwdx;
+    double Ry_gradU_y = R->y.x*dudy + R->y.y*dvdy + R->y.z*dwdy;
+    double Ry_gradU_z = R->y.x*dudz + R->y.y*dvdz + R->y.z*dwdz;
+
+    double Rz_gradU_x = R->z.x*dudx + R->z.y*dvdx + R->z.z*dwdx;
+    double Rz_gradU_y = R->z.x*dudy + R->z.y*dvdy + R->z.z*dwdy;
+    double Rz_gradU_z = R->z.x*dudz + R->z.y*dvdz + R->z.z*dwdz;
+
+    // Now compute M components by multiplying the intermediate products with R^T
+    M.x.x = R->x.x*Rx_gradU_x + R->x.y*Rx_gradU_y + R->x.z*Rx_gradU_z;
+    M.x.y = R->x.x*Ry_gradU_x + R->x.y*Ry_gradU_y + R->x.z*Ry_gradU_z;
+    M.x.z = R->x.x*Rz_gradU_x + R->x.y*Rz_gradU_y + R->x.z*Rz_gradU_z;
+
+    M.y.x = R->y.x*Rx_gradU_x + R->y.y*Rx_gradU_y + R->y.z*Rx_gradU_z;
+    M.y.y = R->y.x*Ry_gradU_x + R->y.y*Ry_gradU_y + R->y.z*Ry_gradU_z;
+    M.y.z = R->y.x*Rz_gradU_x + R->y.y*Rz_gradU_y + R->y.z*Rz_gradU_z;
+
+    M.z.x = R->z.x*Rx_gradU_x + R->z.y*Rx_gradU_y + R->z.z*Rx_gradU_z;
+    M.z.y = R->z.x*Ry_gradU_x + R->z.y*Ry_gradU_y + R->z.z*Ry_gradU_z;
+    M.z.z = R->z.x*Rz_gradU_x + R->z.y*Rz_gradU_y + R->z.z*Rz_gradU_z;
+
+    // Compute the off-diagonal elements of the Omega tensor in the eigenvector basis
+    double omega_xy = (Lambda->y*M.x.y + Lambda->x*M.y.x)/(Lambda->y - Lambda->x);
+    double omega_xz = (Lambda->z*M.x.z + Lambda->x*M.z.x)/(Lambda->z - Lambda->x);
+    double omega_yz = (Lambda->z*M.y.z + Lambda->y*M.z.y)/(Lambda->z - Lambda->y);
+
+    // Calculate intermediate rotation combinations for each direction
+    // x-direction rotation combinations
+    double rot_x_xy_yz = (R->x.x*omega_xy - R->x.z*omega_yz);  // xy rotation minus yz rotation, x components
+    double rot_x_xy_xz = (R->x.y*omega_xy + R->x.z*omega_xz);  // xy rotation plus xz rotation, x components
+    double rot_x_xz_yz = (R->x.x*omega_xz + R->x.y*omega_yz);  // xz rotation plus yz rotation, x components
+
+    // y-direction rotation combinations
+    double rot_y_xy_yz = (R->y.x*omega_xy - R->y.z*omega_yz);  // xy rotation minus yz rotation, y components
+    double rot_y_xy_xz = (R->y.y*omega_xy + R->y.z*omega_xz);  // xy rotation plus xz rotation, y components
+    double rot_y_xz_yz = (R->y.x*omega_xz + R->y.y*omega_yz);  // xz rotation plus yz rotation, y components
+
+    // z-direction rotation combinations
+    double rot_z_xy_yz = (R->z.x*omega_xy - R->z.z*omega_yz);  // xy rotation minus yz rotation, z components
+    double rot_z_xy_xz = (R->z.y*omega_xy + R->z.z*omega_xz);  // xy rotation plus xz rotation, z components
+    double rot_z_xz_yz = (R->z.x*omega_xz + R->z.y*omega_yz);  // xz rotation plus yz rotation, z components
+
+    /* Calculate the components of the Omega tensor in the physical coordinate system
+     * 
+     * The Omega tensor represents the rotational part of the velocity gradient tensor
+     * and is computed through the following steps:
+     * 
+     * 1. We already have:
+     *    - R: eigenvector matrix of the conformation tensor
+     *    - rot_*_*_*: pre-computed rotation combinations for each direction
+     * 
+     * 2. Mathematical background:
+     *    Omega = R * Omega_eigen * R^T
+     *    where Omega_eigen is the rotation tensor in eigenvector space
+     * 
+     * 3. The components are calculated using the rotation combinations:
+     *    - rot_i_jk_lm represents combined rotations in the i-direction
+     *    - Each component Omega_ij is a linear combination of these rotations
+     */
+
+    // Compute x-row components of Omega
+    Omega->x.x = R->x.y*rot_x_xy_yz  // xy-yz rotation contribution
+              - R->x.x*rot_x_xy_xz   // xy-xz rotation contribution
+              + R->x.z*rot_x_xz_yz;  // xz-yz rotation contribution
+    
+    Omega->x.y = R->y.y*rot_x_xy_yz  // xy-yz rotation mapped to y-direction
+              - R->y.x*rot_x_xy_xz   // xy-xz rotation mapped to y-direction
+              + R->y.z*rot_x_xz_yz;  // xz-yz rotation mapped to y-direction
+    
+    Omega->x.z = R->z.y*rot_x_xy_yz  // xy-yz rotation mapped to z-direction
+              - R->z.x*rot_x_xy_xz   // xy-xz rotation mapped to z-direction
+              + R->z.z*rot_x_xz_yz;  // xz-yz rotation mapped to z-direction
+
+    // Compute y-row components using similar pattern
+    Omega->y.x = R->x.y*rot_y_xy_yz - R->x.x*rot_y_xy_xz + R->x.z*rot_y_xz_yz;
+    Omega->y.y = R->y.y*rot_y_xy_yz - R->y.x*rot_y_xy_xz + R->y.z*rot_y_xz_yz;
+    Omega->y.z = R->z.y*rot_y_xy_yz - R->z.x*rot_y_xy_xz + R->z.z*rot_y_xz_yz;
+
+    // Compute z-row components using similar pattern
+    Omega->z.x = R->x.y*rot_z_xy_yz - R->x.x*rot_z_xy_xz + R->x.z*rot_z_xz_yz;
+    Omega->z.y = R->y.y*rot_z_xy_yz - R->y.x*rot_z_xy_xz + R->y.z*rot_z_xz_yz;
+    Omega->z.z = R->z.y*rot_z_xy_yz - R->z.x*rot_z_xy_xz + R->z.z*rot_z_xz_yz;
+
+    /* Note: The resulting Omega tensor is skew-symmetric, meaning:
+     * Omega_ij = -Omega_ji
+     * This property is automatically satisfied by the construction above
+     * and is essential for preserving the physical meaning of rotation
+     */
+
+    // Extract diagonal components of M (velocity gradient tensor in eigenvector basis)
+    double M_diag_x = M.x.x, M_diag_y = M.y.y, M_diag_z = M.z.z;
+
+    /*
+    Compute B tensor: B = R * diag(M) * R^T
+    - This transforms the diagonal velocity gradient tensor back to the original coordinate system
+    - B is symmetric, so we only need to compute the upper triangle
+    */
+
+    // Compute diagonal elements of B
+    B->x.x = M_diag_x*sq(R->x.x) + M_diag_y*sq(R->x.y) + M_diag_z*sq(R->x.z);
+    B->y.y = M_diag_x*sq(R->y.x) + M_diag_y*sq(R->y.y) + M_diag_z*sq(R->y.z);
+    B->z.z = M_diag_x*sq(R->z.x) + M_diag_y*sq(R->x.y) + M_diag_z*sq(R->z.z);
+
+    // Compute off-diagonal elements of B (upper triangle)
+    B->x.y = M_diag_x*R->x.x*R->y.x + M_diag_y*R->x.y*R->y.y + M_diag_z*R->x.z*R->y.z;
+    B->x.z = M_diag_x*R->x.x*R->z.x + M_diag_y*R->x.y*R->z.y + M_diag_z*R->x.z*R->z.z;
+    B->y.z = M_diag_x*R->y.x*R->z.x + M_diag_y*R->y.y*R->z.y + M_diag_z*R->y.z*R->z.z;
+
+    // Fill in lower triangle using symmetry of B
+    B->y.x = B->x.y;
+    B->z.x = B->x.z;
+    B->z.y = B->y.z;
+  }
+}
+
+/**
+*upper_convected_step()* advances the symmetric tensor *Psi* over *dt*
+with the upper convective term
+$\partial_t \Psi = 2 \mathbf{B} + (\Omega \cdot \Psi -\Psi \cdot \Omega)$. */
+
+static void upper_convected_step (pseudo_t3d * Psi, pseudo_t3d * B,
+				  pseudo_t3d * Omega, double dt)
+{
+  // save old values of Psi components
+  double old_Psi11 = Psi->x.x;
+  double old_Psi22 = Psi->y.y;
+  double old_Psi33 = Psi->z.z;
+  double old_Psi12 = Psi->x.y;
+  double old_Psi13 = Psi->x.z;
+  double old_Psi23 = Psi->y.z;
+
+  // Psi11
+  Psi->x.x += dt * (2.0 * B->x.x + Omega->x.y * old_Psi12 - Omega->y.x * old_Psi12 + Omega->x.z * old_Psi13 - Omega->z.x * old_Psi13);
+  // Psi22
+  Psi->y.y += dt * (2.0 * B->y.y - Omega->x.y * old_Psi12 + Omega->y.x * old_Psi12 + Omega->y.z * old_Psi23 - Omega->z.y * old_Psi23);
+  // Psi33
+  Psi->z.z += dt * (2.0 * B->z.z - Omega->x.z * old_Psi13 + Omega->z.x * old_Psi13 - Omega->y.z * old_Psi23 + Omega->z.y * old_Psi23);
+  // Psi12
+  Psi->x.y += dt * (2.0 * B->x.y + Omega->x.x * old_Psi12 - Omega->x.y * old_Psi11 + Omega->x.y * old_Psi22 - Omega->y.y * old_Psi12 + Omega->x.z * old_Psi23 - Omega->z.y * old_Psi13);
+  // Psi13
+  Psi->x.z += dt * (2.0 * B->x.z + Omega->x.x*old_Psi13 - Omega->x.z * old_Psi11 + Omega->x.y*old_Psi23 - Omega->y.z*old_Psi12 + Omega->x.z * old_Psi33 - Omega->z.z * old_Psi13);
+  // Psi23
+  Psi->y.z += dt * (2.0 * B->y.z + Omega->y.x * old_Psi13 - Omega->x.z * old_Psi12 + Omega->y.y * old_Psi23 - Omega->y.z * old_Psi22 + Omega->y.z * old_Psi33 - Omega->z.z * old_Psi23);
+}
+
+#if TREE
+/**
+## Local time stepping of the constitutive update (3D, trees)
+
+On octrees the timestep is set by the finest cells, while most of the
+cost of *tracer_advection* is the update of each cell (two
+eigen-decompositions per cell), including in the coarse cells far from
+the interface. With *ltsLevels > 0*, a cell of level $l$ only applies
+the upper convective and relaxation terms every
+$2^{\min(ltsLevels,\,d - l)}$ timesteps ($d$ is the depth of the
+tree over all processes, so that the schedule does not depend on the
+domain decomposition), over the time elapsed since its last update.
+The cells at the maximum level are updated at every timestep.
+
+$\Psi$ is then the state variable. It is stored in *ltsPsi* and
+advected at every timestep, with the global timestep and the face
+velocity, so that the transport is not changed. $\mathbf{A}$ and
+$\mathbf{T}$ are only rebuilt when a cell is updated: in coarse cells,
+they lag by up to $2^{ltsLevels} - 1$ timesteps. *ltsLevels* should
+thus only be used when the stress varies slowly in the coarse regions
+of the mesh. *ltsLast* is the time of the last update of each cell.
+
+The upper convective term is explicit over the time elapsed since the
+last update, which is only stable if this time is small compared to
+$1/\|\nabla\mathbf{u}\|$. A cell is thus also updated when waiting
+for one more timestep would take this time beyond
+$ltsCFL/\|\nabla\mathbf{u}\|$. Where the flow is strong enough, this
+falls back to an update at every timestep. The rotation rate $\Omega$
+is also large when two eigenvalues are close; in a cell which has
+skipped timesteps, if it exceeds $ltsCFL$ over the interval, the
+eigenvalues are treated as equal ($\Omega = 0$, $\mathbf{B} =
+\mathbf{D}$) for this update. The relaxation is integrated exactly and
+does not limit the interval.
+
+Even where every cell is updated at every timestep (e.g. on a uniform
+grid), this is not the update used without *ltsLevels*: $\Psi$ is the
+state variable and the relaxation is done in its eigenbasis. The
+results differ well below the discretisation error: on the 3D
+lid-driven cavity of [costAccuracy.sh](../testCases/costAccuracy.sh)
+at level 4, the RMS error on the kinetic energy goes from 4.74% to
+4.80% with *ltsLevels = 1*.
+
+*ltsPsi* is not dumped: on restart, it is rebuilt from $\mathbf{A}$.
+This cannot be combined with the quasi-steady path (*WiFast*). */
+
+int ltsLevels = 0;
+double ltsCFL = 0.5;
+scalar * ltsPsi = NULL;
+(const) scalar ltsLast = zeroc;
+
+event defaults (i = 0) {
+  if (ltsLevels > 0 && !ltsPsi) {
+    if (WiFast > 0.) {
+      fprintf (ferr, "error: ltsLevels and WiFast cannot be used together\n");
+      exit (1);
+    }
+    for (int k = 0; k < 6; k++) {
+      scalar s = new scalar;
+      s.nodump = true;
+      ltsPsi = list_append (ltsPsi, s);
+    }
+    ltsLast = new scalar;
+    ltsLast.nodump = true;
+    ltsLast.refine = refine_injection;
+  }
+}
+
+event cleanup (i = end) {
+  free (ltsPsi), ltsPsi = NULL;
+}
+
+/**
+*lts_due()* is true if the cell is updated during this timestep,
+either on its schedule or to keep the explicit step stable. */
+
+static inline bool lts_due (Point point, int maxlevel)
+{
+  int period = 1 << min (ltsLevels, maxlevel - level);
+  if ((iter + 1) % period == 0)
+    return true;
+  double grad = 0.;
+  foreach_dimension()
+    grad += (sq(u.x[1] - u.x[-1]) + sq(u.x[0,1] - u.x[0,-1]) +
+	     sq(u.x[0,0,1] - u.x[0,0,-1]));
+  grad = sqrt (grad)/(2.*Delta);
+  return (t + 2.*dt - ltsLast[])*grad > ltsCFL;
+}
+
+/**
+*lts_tensor()* is $\mathbf{R}\,\mathrm{diag}(\Lambda)\,\mathbf{R}^T$,
+packed as (11, 22, 33, 12, 13, 23). */
+
+static void lts_tensor (pseudo_v3d * Lambda, pseudo_t3d * R, double a[6])
+{
+  a[0] = Lambda->x*sq(R->x.x) + Lambda->y*sq(R->x.y) + Lambda->z*sq(R->x.z);
+  a[1] = Lambda->x*sq(R->y.x) + Lambda->y*sq(R->y.y) + Lambda->z*sq(R->y.z);
+  a[2] = Lambda->x*sq(R->z.x) + Lambda->y*sq(R->z.y) + Lambda->z*sq(R->z.z);
+  a[3] = Lambda->x*R->x.x*R->y.x + Lambda->y*R->x.y*R->y.y + Lambda->z*R->x.z*R->y.z;
+  a[4] = Lambda->x*R->x.x*R->z.x + Lambda->y*R->x.y*R->z.y + Lambda->z*R->x.z*R->z.z;
+  a[5] = Lambda->x*R->y.x*R->z.x + Lambda->y*R->y.y*R->z.y + Lambda->z*R->y.z*R->z.z;
+}
+
+/**
+*lts_tracer_advection()* replaces the three steps of *tracer_advection*
+below. The relaxation of Oldroyd-B is applied in the eigenbasis of
+$\Psi$, as for the nonlinear models, so that the new $\Psi$ does not
+need another decomposition.
+
+The eigenvalues of $\mathbf{A}$ are the exponentials of those of
+$\Psi$: their differences are only accurate to round-off, which the
+$1/(\Lambda_j - \Lambda_i)$ terms of $\Omega$ amplify. Closer
+eigenvalues are treated as equal. */
+
+#define LTS_DEGENERATE 1e-10
+
+static bool lts_started = false;
+
+static void lts_tracer_advection()
+{
+  scalar Psi11 = ltsPsi[0], Psi22 = ltsPsi[1], Psi33 = ltsPsi[2],
+         Psi12 = ltsPsi[3], Psi13 = ltsPsi[4], Psi23 = ltsPsi[5];
+  scalar last = ltsLast;
+  int maxlevel = grid->maxdepth;
+
+  /**
+  $\Psi$ is initialised from $\mathbf{A}$ at the first timestep (or
+  after a restart), with the boundary conditions of $\mathbf{A}$. */
+
+  if (!lts_started) {
+    scalar * alist = {A11, A22, A33, A12, A13, A23};
+    for (int k = 0; k < 6; k++) {
+      scalar s = ltsPsi[k], a = alist[k];
+      for (int b = 0; b < nboundary; b++) {
+	s.boundary[b] = a.boundary[b];
+	s.boundary_homogeneous[b] = a.boundary_homogeneous[b];
+      }
+    }
+    foreach() {
+      double a[6] = {A11[], A22[], A33[], A12[], A13[], A23[]};
+      if (!conformation_function (a, true)) {
+	fprintf (ferr, "Negative eigenvalue detected: x = %g, y = %g, z = %g\n",
+		 x, y, z);
+	exit (1);
+      }
+      Psi11[] = a[0]; Psi22[] = a[1]; Psi33[] = a[2];
+      Psi12[] = a[3]; Psi13[] = a[4]; Psi23[] = a[5];
+      last[] = t;
+    }
+    lts_started = true;
+  }
+
+  // Upper convective term, over the time since the last update
+  foreach (dynamic) {
+    if (!lts_due (point, maxlevel))
+      continue;
+    pseudo_t3d A, R;
+    init_pseudo_t3d(&R, 0.0);
+    pseudo_v3d Lambda;
+    init_pseudo_v3d(&Lambda, 0.0);
+    A.x.x = Psi11[]; A.x.y = Psi12[]; A.x.z = Psi13[];
+    A.y.x = Psi12[]; A.y.y = Psi22[]; A.y.z = Psi23[];
+    A.z.x = Psi13[]; A.z.y = Psi23[]; A.z.z = Psi33[];
+    diagonalization_3D (&Lambda, &R, &A);
+    Lambda.x = exp(Lambda.x); Lambda.y = exp(Lambda.y); Lambda.z = exp(Lambda.z);
+
+    pseudo_t3d B, Omega, P;
+    double dtl = t + dt - last[];
+    upper_convected_3D (point, &Lambda, &R, &B, &Omega, LTS_DEGENERATE);
+    if (dtl > 1.5*dt &&
+	dtl*max (max (fabs(Omega.x.y), fabs(Omega.x.z)), fabs(Omega.y.z)) > ltsCFL)
+      upper_convected_3D (point, &Lambda, &R, &B, &Omega, HUGE);
+    P.x.x = Psi11[]; P.y.y = Psi22[]; P.z.z = Psi33[];
+    P.x.y = Psi12[]; P.x.z = Psi13[]; P.y.z = Psi23[];
+    upper_convected_step (&P, &B, &Omega, dtl);
+    Psi11[] = P.x.x; Psi22[] = P.y.y; Psi33[] = P.z.z;
+    Psi12[] = P.x.y; Psi13[] = P.x.z; Psi23[] = P.y.z;
+  }
+
+  // Advection of Psi, in all the cells
+  advection (ltsPsi, uf, dt);
+  psi_diffusion (ltsPsi);
+
+  // Relaxation, then A and T
+  foreach (dynamic) {
+    if (!lts_due (point, maxlevel))
+      continue;
+    double dtl = t + dt - last[];
+    last[] = t + dt;
+
+    pseudo_t3d A, R;
+    init_pseudo_t3d(&R, 0.0);
+    pseudo_v3d Lambda;
+    init_pseudo_v3d(&Lambda, 0.0);
+    A.x.x = Psi11[]; A.x.y = Psi12[]; A.x.z = Psi13[];
+    A.y.x = Psi12[]; A.y.y = Psi22[]; A.y.z = Psi23[];
+    A.z.x = Psi13[]; A.z.y = Psi23[]; A.z.z = Psi33[];
+    diagonalization_3D (&Lambda, &R, &A);
+    Lambda.x = exp(Lambda.x); Lambda.y = exp(Lambda.y); Lambda.z = exp(Lambda.z);
+
+#if FENE_P || GIESEKUS
+    double nu = relax_eigenvalues (&Lambda, dtl, lambda[]);
+#else
+    double nu = 1., intFactor = lambda[] != 0. ? exp(-dtl/lambda[]) : 0.;
+    Lambda.x = 1. + (Lambda.x - 1.)*intFactor;
+    Lambda.y = 1. + (Lambda.y - 1.)*intFactor;
+    Lambda.z = 1. + (Lambda.z - 1.)*intFactor;
+#endif
+
+    double a[6];
+    lts_tensor (&Lambda, &R, a);
+    A11[] = a[0]; A22[] = a[1]; A33[] = a[2];
+    A12[] = a[3]; A13[] = a[4]; A23[] = a[5];
+    T11[] = Gp[]*(nu*a[0] - 1.);
+    T22[] = Gp[]*(nu*a[1] - 1.);
+    T33[] = Gp[]*(nu*a[2] - 1.);
+    T12[] = Gp[]*nu*a[3];
+    T13[] = Gp[]*nu*a[4];
+    T23[] = Gp[]*nu*a[5];
+
+    Lambda.x = log(Lambda.x); Lambda.y = log(Lambda.y); Lambda.z = log(Lambda.z);
+    lts_tensor (&Lambda, &R, a);
+    Psi11[] = a[0]; Psi22[] = a[1]; Psi33[] = a[2];
+    Psi12[] = a[3]; Psi13[] = a[4]; Psi23[] = a[5];
+  }
+}
+#endif // TREE
+
 event tracer_advection(i++)
 {
   /**
@@ -583,7 +1606,18 @@ event tracer_advection(i++)
   scalar Psi11 = A11, Psi12 = A12, Psi13 = A13,
          Psi22 = A22, Psi23 = A23, Psi33 = A33;
 
-  foreach() {
+#if TREE
+  if (ltsLevels > 0) {
+    lts_tracer_advection();
+    return 0;
+  }
+#endif
+
+  if (!is_constant (quasiSteady))
+    foreach()
+      quasi_steady (point);
+
+  foreach (dynamic) {
     pseudo_t3d A, R;
     init_pseudo_t3d(&R, 0.0);
     pseudo_v3d Lambda;
@@ -593,6 +1627,14 @@ event tracer_advection(i++)
     A.y.x = A12[]; A.y.y = A22[]; A.y.z = A23[];
     A.z.x = A13[]; A.z.y = A23[]; A.z.z = A33[];
 
+    // Quasi-steady cells only need Psi for the advection of their neighbours
+    if (quasiSteady[]) {
+      log_near_equilibrium (&A);
+      Psi11[] = A.x.x; Psi22[] = A.y.y; Psi33[] = A.z.z;
+      Psi12[] = A.x.y; Psi13[] = A.x.z; Psi23[] = A.y.z;
+      continue;
+    }
+
     // Diagonalize the conformation tensor A to obtain the eigenvalues Lambda and eigenvectors R
     diagonalization_3D (&Lambda, &R, &A);
 
@@ -616,190 +1658,8 @@ event tracer_advection(i++)
     Psi23[] = R.y.x*R.z.x*log(Lambda.x) + R.y.y*R.z.y*log(Lambda.y) + R.y.z*R.z.z*log(Lambda.z);
 
     // Compute B and Omega tensors (3D version)
-    pseudo_t3d B, M, Omega;
-    init_pseudo_t3d(&B, 0.0);
-    init_pseudo_t3d(&M, 0.0);
-    init_pseudo_t3d(&Omega, 0.0);
-
-    // Check if any pair of eigenvalues are numerically equal (within a small tolerance)
-    if (fabs(Lambda.x - Lambda.y) <= 1e-20 || fabs(Lambda.y - Lambda.z) <= 1e-20 || fabs(Lambda.z - Lambda.x) <= 1e-20) {
-      // In case of equal eigenvalues, the calculations for B and Omega simplify significantly
-      // B is grad U and Omega is zero.
-
-      // Compute off-diagonal elements of B using central differences
-      // These represent the symmetric part of the velocity gradient tensor
-      B.x.y = (u.y[1,0,0] - u.y[-1,0,0] + u.x[0,1,0] - u.x[0,-1,0])/(4.*Delta);  // (dv/dx + du/dy)/2
-      B.x.z = (u.z[1,0,0] - u.z[-1,0,0] + u.x[0,0,1] - u.x[0,0,-1])/(4.*Delta);  // (dw/dx + du/dz)/2
-      B.y.z = (u.z[0,1,0] - u.z[0,-1,0] + u.y[0,0,1] - u.y[0,0,-1])/(4.*Delta);  // (dw/dy + dv/dz)/2
-
-      // Compute diagonal elements of B
-      // These represent the normal strain rates
-      B.x.x = (u.x[1,0,0] - u.x[-1,0,0])/(2.*Delta);  // du/dx
-      B.y.y = (u.y[0,1,0] - u.y[0,-1,0])/(2.*Delta);  // dv/dy
-      B.z.z = (u.z[0,0,1] - u.z[0,0,-1])/(2.*Delta);  // dw/dz
-
-      // Set all components of Omega to zero
-      // This is because Omega represents the antisymmetric part of the velocity gradient tensor,
-      // which vanishes when eigenvalues are equal
-      Omega.x.y = Omega.x.z = Omega.y.z = Omega.y.x = Omega.z.x = Omega.z.y = 0.;
-
-    } else {
-      
-      /*
-      ### Compute the velocity gradient tensor components using central differences
-      - These represent the spatial derivatives of each velocity component
-      - These gradients form the velocity gradient tensor (nablaU):
-      [ dudx  dudy  dudz ]
-      [ dvdx  dvdy  dvdz ]
-      [ dwdx  dwdy  dwdz ]
-      */
-
-      // Derivatives of u (x-component of velocity)
-      double dudx = (u.x[1,0,0] - u.x[-1,0,0])/(2.0*Delta);  // du/dx
-      double dudy = (u.x[0,1,0] - u.x[0,-1,0])/(2.0*Delta);  // du/dy
-      double dudz = (u.x[0,0,1] - u.x[0,0,-1])/(2.0*Delta);  // du/dz
-
-      // Derivatives of v (y-component of velocity)
-      double dvdx = (u.y[1,0,0] - u.y[-1,0,0])/(2.0*Delta);  // dv/dx
-      double dvdy = (u.y[0,1,0] - u.y[0,-1,0])/(2.0*Delta);  // dv/dy
-      double dvdz = (u.y[0,0,1] - u.y[0,0,-1])/(2.0*Delta);  // dv/dz
-
-      // Derivatives of w (z-component of velocity)
-      double dwdx = (u.z[1,0,0] - u.z[-1,0,0])/(2.0*Delta);  // dw/dx
-      double dwdy = (u.z[0,1,0] - u.z[0,-1,0])/(2.0*Delta);  // dw/dy
-      double dwdz = (u.z[0,0,1] - u.z[0,0,-1])/(2.0*Delta);  // dw/dz
-
-      /*
-      Calculate the M tensor through matrix multiplication: M = R * (nablaU)^T R^T. This represents the velocity gradient tensor transformed to the eigenvector basis of the conformation tensor.
-      
-      * Steps:
-      1. Compute intermediate products (R * nablaU^T):
-         - Store row-wise products in Rx_gradU_*, Ry_gradU_*, Rz_gradU_*
-         - Each variable represents one row of the intermediate matrix
-      2. Multiply by R^T to obtain the final M tensor:
-         - M.i.j represents the (i,j) component of the transformed velocity gradient
-         - This transformation expresses the velocity gradient in the eigenvector basis
-         - The resulting M tensor is used to compute Omega (Ω) and B tensors, such that 
-      */
-
-      // First, compute intermediate products of R and (nablaU)^T
-      double Rx_gradU_x = R.x.x*dudx + R.x.y*dvdx + R.x.z*dwdx;
-      double Rx_gradU_y = R.x.x*dudy + R.x.y*dvdy + R.x.z*dwdy;
-      double Rx_gradU_z = R.x.x*dudz + R.x.y*dvdz + R.x.z*dwdz;
-
-      double Ry_gradU_x = R.y.x*dudx + R.y.y*dvdx + R.y.z*dwdx;
-      double Ry_gradU_y = R.y.x*dudy + R.y.y*dvdy + R.y.z*dwdy;
-      double Ry_gradU_z = R.y.x*dudz + R.y.y*dvdz + R.y.z*dwdz;
-
-      double Rz_gradU_x = R.z.x*dudx + R.z.y*dvdx + R.z.z*dwdx;
-      double Rz_gradU_y = R.z.x*dudy + R.z.y*dvdy + R.z.z*dwdy;
-      double Rz_gradU_z = R.z.x*dudz + R.z.y*dvdz + R.z.z*dwdz;
-
-      // Now compute M components by multiplying the intermediate products with R^T
-      M.x.x = R.x.x*Rx_gradU_x + R.x.y*Rx_gradU_y + R.x.z*Rx_gradU_z;
-      M.x.y = R.x.x*Ry_gradU_x + R.x.y*Ry_gradU_y + R.x.z*Ry_gradU_z;
-      M.x.z = R.x.x*Rz_gradU_x + R.x.y*Rz_gradU_y + R.x.z*Rz_gradU_z;
-
-      M.y.x = R.y.x*Rx_gradU_x + R.y.y*Rx_gradU_y + R.y.z*Rx_gradU_z;
-      M.y.y = R.y.x*Ry_gradU_x + R.y.y*Ry_gradU_y + R.y.z*Ry_gradU_z;
-      M.y.z = R.y.x*Rz_gradU_x + R.y.y*Rz_gradU_y + R.y.z*Rz_gradU_z;
-
-      M.z.x = R.z.x*Rx_gradU_x + R.z.y*Rx_gradU_y + R.z.z*Rx_gradU_z;
-      M.z.y = R.z.x*Ry_gradU_x + R.z.y*Ry_gradU_y + R.z.z*Ry_gradU_z;
-      M.z.z = R.z.x*Rz_gradU_x + R.z.y*Rz_gradU_y + R.z.z*Rz_gradU_z;
-
-      // Compute the off-diagonal elements of the Omega tensor in the eigenvector basis
-      double omega_xy = (Lambda.y*M.x.y + Lambda.x*M.y.x)/(Lambda.y - Lambda.x);
-      double omega_xz = (Lambda.z*M.x.z + Lambda.x*M.z.x)/(Lambda.z - Lambda.x);
-      double omega_yz = (Lambda.z*M.y.z + Lambda.y*M.z.y)/(Lambda.z - Lambda.y);
-
-      // Calculate intermediate rotation combinations for each direction
-      // x-direction rotation combinations
-      double rot_x_xy_yz = (R.x.x*omega_xy - R.x.z*omega_yz);  // xy rotation minus yz rotation, x components
-      double rot_x_xy_xz = (R.x.y*omega_xy + R.x.z*omega_xz);  // xy rotation plus xz rotation, x components
-      double rot_x_xz_yz = (R.x.x*omega_xz + R.x.y*omega_yz);  // xz rotation plus yz rotation, x components
-
-      // y-direction rotation combinations
-      double rot_y_xy_yz = (R.y.x*omega_xy - R.y.z*omega_yz);  // xy rotation minus yz rotation, y components
-      double rot_y_xy_xz = (R.y.y*omega_xy + R.y.z*omega_xz);  // xy rotation plus xz rotation, y components
-      double rot_y_xz_yz = (R.y.x*omega_xz + R.y.y*omega_yz);  // xz rotation plus yz rotation, y components
-
-      // z-direction rotation combinations
-      double rot_z_xy_yz = (R.z.x*omega_xy - R.z.z*omega_yz);  // xy rotation minus yz rotation, z components
-      double rot_z_xy_xz = (R.z.y*omega_xy + R.z.z*omega_xz);  // xy rotation plus xz rotation, z components
-      double rot_z_xz_yz = (R.z.x*omega_xz + R.z.y*omega_yz);  // xz rotation plus yz rotation, z components
-
-      /* Calculate the components of the Omega tensor in the physical coordinate system
-       * 
-       * The Omega tensor represents the rotational part of the velocity gradient tensor
-       * and is computed through the following steps:
-       * 
-       * 1. We already have:
-       *    - R: eigenvector matrix of the conformation tensor
-       *    - rot_*_*_*: pre-computed rotation combinations for each direction
-       * 
-       * 2. Mathematical background:
-       *    Omega = R * Omega_eigen * R^T
-       *    where Omega_eigen is the rotation tensor in eigenvector space
-       * 
-       * 3. The components are calculated using the rotation combinations:
-       *    - rot_i_jk_lm represents combined rotations in the i-direction
-       *    - Each component Omega_ij is a linear combination of these rotations
-       */
-
-      // Compute x-row components of Omega
-      Omega.x.x = R.x.y*rot_x_xy_yz  // xy-yz rotation contribution
-                - R.x.x*rot_x_xy_xz   // xy-xz rotation contribution
-                + R.x.z*rot_x_xz_yz;  // xz-yz rotation contribution
-      
-      Omega.x.y = R.y.y*rot_x_xy_yz  // xy-yz rotation mapped to y-direction
-                - R.y.x*rot_x_xy_xz   // xy-xz rotation mapped to y-direction
-                + R.y.z*rot_x_xz_yz;  // xz-yz rotation mapped to y-direction
-      
-      Omega.x.z = R.z.y*rot_x_xy_yz  // xy-yz rotation mapped to z-direction
-                - R.z.x*rot_x_xy_xz   // xy-xz rotation mapped to z-direction
-                + R.z.z*rot_x_xz_yz;  // xz-yz rotation mapped to z-direction
-
-      // Compute y-row components using similar pattern
-      Omega.y.x = R.x.y*rot_y_xy_yz - R.x.x*rot_y_xy_xz + R.x.z*rot_y_xz_yz;
-      Omega.y.y = R.y.y*rot_y_xy_yz - R.y.x*rot_y_xy_xz + R.y.z*rot_y_xz_yz;
-      Omega.y.z = R.z.y*rot_y_xy_yz - R.z.x*rot_y_xy_xz + R.z.z*rot_y_xz_yz;
-
-      // Compute z-row components using similar pattern
-      Omega.z.x = R.x.y*rot_z_xy_yz - R.x.x*rot_z_xy_xz + R.x.z*rot_z_xz_yz;
-      Omega.z.y = R.y.y*rot_z_xy_yz - R.y.x*rot_z_xy_xz + R.y.z*rot_z_xz_yz;
-      Omega.z.z = R.z.y*rot_z_xy_yz - R.z.x*rot_z_xy_xz + R.z.z*rot_z_xz_yz;
-
-      /* Note: The resulting Omega tensor is skew-symmetric, meaning:
-       * Omega_ij = -Omega_ji
-       * This property is automatically satisfied by the construction above
-       * and is essential for preserving the physical meaning of rotation
-       */
-
-      // Extract diagonal components of M (velocity gradient tensor in eigenvector basis)
-      double M_diag_x = M.x.x, M_diag_y = M.y.y, M_diag_z = M.z.z;
-
-      /*
-      Compute B tensor: B = R * diag(M) * R^T
-      - This transforms the diagonal velocity gradient tensor back to the original coordinate system
-      - B is symmetric, so we only need to compute the upper triangle
-      */
-
-      // Compute diagonal elements of B
-      B.x.x = M_diag_x*sq(R.x.x) + M_diag_y*sq(R.x.y) + M_diag_z*sq(R.x.z);
-      B.y.y = M_diag_x*sq(R.y.x) + M_diag_y*sq(R.y.y) + M_diag_z*sq(R.y.z);
-      B.z.z = M_diag_x*sq(R.z.x) + M_diag_y*sq(R.x.y) + M_diag_z*sq(R.z.z);
-
-      // Compute off-diagonal elements of B (upper triangle)
-      B.x.y = M_diag_x*R.x.x*R.y.x + M_diag_y*R.x.y*R.y.y + M_diag_z*R.x.z*R.y.z;
-      B.x.z = M_diag_x*R.x.x*R.z.x + M_diag_y*R.x.y*R.z.y + M_diag_z*R.x.z*R.z.z;
-      B.y.z = M_diag_x*R.y.x*R.z.x + M_diag_y*R.y.y*R.z.y + M_diag_z*R.y.z*R.z.z;
-
-      // Fill in lower triangle using symmetry of B
-      B.y.x = B.x.y;
-      B.z.x = B.x.z;
-      B.z.y = B.y.z;
-    }
+    pseudo_t3d B, Omega;
+    upper_convected_3D (point, &Lambda, &R, &B, &Omega, 1e-20);
 
     /**
     We now advance $\Psi$ in time, adding the upper convective
@@ -807,31 +1667,17 @@ event tracer_advection(i++)
     This step 1: \partial_t \Psi = 2 \mathbf{B} + (\Omega \cdot \Psi -\Psi \cdot \Omega)
     */
 
-    // save old values of Psi components
-    double old_Psi11 = Psi11[];
-    double old_Psi22 = Psi22[];
-    double old_Psi33 = Psi33[];
-    double old_Psi12 = Psi12[];
-    double old_Psi13 = Psi13[];
-    double old_Psi23 = Psi23[];
-
-    // Psi11
-    Psi11[] += dt * (2.0 * B.x.x + Omega.x.y * old_Psi12 - Omega.y.x * old_Psi12 + Omega.x.z * old_Psi13 - Omega.z.x * old_Psi13);
-    // Psi22
-    Psi22[] += dt * (2.0 * B.y.y - Omega.x.y * old_Psi12 + Omega.y.x * old_Psi12 + Omega.y.z * old_Psi23 - Omega.z.y * old_Psi23);
-    // Psi33
-    Psi33[] += dt * (2.0 * B.z.z - Omega.x.z * old_Psi13 + Omega.z.x * old_Psi13 - Omega.y.z * old_Psi23 + Omega.z.y * old_Psi23);
-    // Psi12
-    Psi12[] += dt * (2.0 * B.x.y + Omega.x.x * old_Psi12 - Omega.x.y * old_Psi11 + Omega.x.y * old_Psi22 - Omega.y.y * old_Psi12 + Omega.x.z * old_Psi23 - Omega.z.y * old_Psi13);
-    // Psi13
-    Psi13[] += dt * (2.0 * B.x.z + Omega.x.x*old_Psi13 - Omega.x.z * old_Psi11 + Omega.x.y*old_Psi23 - Omega.y.z*old_Psi12 + Omega.x.z * old_Psi33 - Omega.z.z * old_Psi13);
-    // Psi23
-    Psi23[] += dt * (2.0 * B.y.z + Omega.y.x * old_Psi13 - Omega.x.z * old_Psi12 + Omega.y.y * old_Psi23 - Omega.y.z * old_Psi22 + Omega.y.z * old_Psi33 - Omega.z.z * old_Psi23);
-
+    pseudo_t3d P;
+    P.x.x = Psi11[]; P.y.y = Psi22[]; P.z.z = Psi33[];
+    P.x.y = Psi12[]; P.x.z = Psi13[]; P.y.z = Psi23[];
+    upper_convected_step (&P, &B, &Omega, dt);
+    Psi11[] = P.x.x; Psi22[] = P.y.y; Psi33[] = P.z.z;
+    Psi12[] = P.x.y; Psi13[] = P.x.z; Psi23[] = P.y.z;
   }
 
   // Advection of Psi, which is the log-conformation tensor
   advection ({Psi11, Psi12, Psi13, Psi22, Psi23, Psi33}, uf, dt);
+  psi_diffusion ({Psi11, Psi12, Psi13, Psi22, Psi23, Psi33});
 
   /**
   ### Convert back to A and T
@@ -841,12 +1687,28 @@ event tracer_advection(i++)
   exponentiation of eigenvalues, and application of the relaxation factor.
   */
 
-  foreach() {
+  foreach (dynamic) {
     pseudo_t3d A, R;
     init_pseudo_t3d(&R, 0.0);
     pseudo_v3d Lambda;
     init_pseudo_v3d(&Lambda, 0.0);
 
+    // Quasi-steady closure, see quasi_steady()
+    if (quasiSteady[]) {
+      pseudo_t3d G;
+      velocity_gradient (point, &G);
+      quasi_steady_conformation (&G, lambda[], &A);
+      A11[] = A.x.x; A22[] = A.y.y; A33[] = A.z.z;
+      A12[] = A.x.y; A13[] = A.x.z; A23[] = A.y.z;
+      T11[] = Gp[]*(A.x.x/A_EQUILIBRIUM - 1.);
+      T22[] = Gp[]*(A.y.y/A_EQUILIBRIUM - 1.);
+      T33[] = Gp[]*(A.z.z/A_EQUILIBRIUM - 1.);
+      T12[] = Gp[]*A.x.y/A_EQUILIBRIUM;
+      T13[] = Gp[]*A.x.z/A_EQUILIBRIUM;
+      T23[] = Gp[]*A.y.z/A_EQUILIBRIUM;
+      continue;
+    }
+
     // Reconstruct the log-conformation tensor from its components
     A.x.x = Psi11[]; A.x.y = Psi12[]; A.x.z = Psi13[];
     A.y.x = Psi12[]; A.y.y = Psi22[]; A.y.z = Psi23[];
@@ -860,6 +1722,13 @@ event tracer_advection(i++)
     Lambda.y = exp(Lambda.y);
     Lambda.z = exp(Lambda.z);
 
+#if FENE_P || GIESEKUS
+    // Nonlinear models relax the eigenvalues of A, see relax_eigenvalues()
+    double nu = relax_eigenvalues (&Lambda, dt, lambda[]);
+#else
+    double nu = 1.;
+#endif
+
     // Reconstruct A using A = R * diag(Lambda) * R^T
     A.x.x = Lambda.x * sq(R.x.x) + Lambda.y * sq(R.x.y) + Lambda.z * sq(R.x.z);
     A.x.y = Lambda.x * R.x.x * R.y.x + Lambda.y * R.x.y * R.y.y + Lambda.z * R.x.z * R.y.z;
@@ -871,6 +1740,7 @@ event tracer_advection(i++)
     A.z.y = A.y.z;
     A.z.z = Lambda.x * sq(R.z.x) + Lambda.y * sq(R.z.y) + Lambda.z * sq(R.z.z);
 
+#if !FENE_P && !GIESEKUS
     // Apply relaxation using the relaxation time lambda
     double intFactor = lambda[] != 0. ? exp(-dt/lambda[]) : 0.;
 
@@ -882,6 +1752,7 @@ event tracer_advection(i++)
     A.z.y = A.y.z;
     foreach_dimension()
       A.x.x = 1. + (A.x.x - 1.)*intFactor;
+#endif
 
     /*
     Get Aij from A. These commands might look repetitive. But, I do this so that in the future, generalization to tensor only form is easier.
@@ -896,17 +1767,89 @@ event tracer_advection(i++)
     A13[] = A.x.z;
     A23[] = A.y.z;
 
-    // Compute the stress tensor T using the polymer modulus Gp
-    T11[] = Gp[]*(A.x.x - 1.);
-    T22[] = Gp[]*(A.y.y - 1.);
-    T33[] = Gp[]*(A.z.z - 1.);
-    T12[] = Gp[]*A.x.y;
-    T13[] = Gp[]*A.x.z;
-    T23[] = Gp[]*A.y.z;
+    // Compute the stress tensor T using the polymer modulus Gp (nu = 1 except for FENE-P)
+    T11[] = Gp[]*(nu*A.x.x - 1.);
+    T22[] = Gp[]*(nu*A.y.y - 1.);
+    T33[] = Gp[]*(nu*A.z.z - 1.);
+    T12[] = Gp[]*nu*A.x.y;
+    T13[] = Gp[]*nu*A.x.z;
+    T23[] = Gp[]*nu*A.y.z;
   }
 }
 #endif
 
+/**
+## Both-sides diffusion stabilisation
+
+The polymeric stress enters the momentum equation explicitly (see the
+acceleration event below). When the solvent viscosity is small
+compared to the polymeric viscosity $G_p\lambda$, this explicit
+coupling is stiff and forces timesteps well below the capillary
+limit. Following the both-sides diffusion (BSD) idea of Guénette \& Fortin
+(1995, *J. Non-Newton. Fluid Mech.* 60, 27--52), an artificial viscosity $\mu_a$ is
+added on both sides of the momentum equation
+$$
+\rho\frac{\mathbf{u}^{n+1} - \mathbf{u}^*}{\Delta t} -
+\nabla\cdot(2(\mu_s + \mu_a)\mathbf{D}^{n+1}) =
+- \nabla\cdot(2\mu_a\mathbf{D}^*) + \nabla\cdot\mathbf{T} + \dots
+$$
+The left-hand side is folded into the existing implicit multigrid
+solve of [viscosity.h](http://basilisk.fr/src/viscosity.h), while the
+right-hand side is applied with *viscosity_explicit()* which uses the
+same discrete operator. The explicit part acts on the velocity at the
+start of the viscous step, before
+[centered.h](http://basilisk.fr/src/navier-stokes/centered.h) adds the
+pressure gradient and acceleration, whereas the implicit part acts on
+the predicted velocity. The two contributions thus leave a residual
+$\nabla\cdot(2\mu_a\mathbf{D}(\mathbf{u}^{n+1} - \mathbf{u}^n))$,
+of order $\Delta t$, which damps transients and only vanishes when
+the velocity no longer changes from one timestep to the next.
+
+The artificial viscosity is $\beta$ times the effective polymeric
+viscosity over one timestep
+$$
+\mu_a = \beta G_p \lambda \left(1 - e^{-\Delta t/\lambda}\right)
+$$
+which tends to $\beta G_p\lambda$ for $\lambda \ll \Delta t$ and
+remains bounded ($\beta G_p\Delta t$) in the elastic limit
+$\lambda \to \infty$. $\beta$ is set with *betaBSD* (typically 0.5
+to 1). This requires a variable viscosity field which is recomputed
+at each timestep, as done by the *properties* event of
+[two-phaseVE.h](two-phaseVE.h): $\mu_a$ is added to it before the
+viscous solve and is not removed afterwards. */
+
+static void bsd_viscosity (face vector mua)
+{
+  foreach_face() {
+    double eta = 0.;
+    for (int i = -1; i <= 0; i++)
+      if (lambda[i] > 0.)
+        eta += Gp[i]*lambda[i]*(1. - exp(-dt/lambda[i]))/2.;
+    mua.x[] = fm.x[]*betaBSD*eta;
+  }
+}
+
+/**
+Our *viscous_term* event is executed before that of
+[centered.h](http://basilisk.fr/src/navier-stokes/centered.h). The
+explicit part is applied first, then $\mu_a$ is added to the
+viscosity used by the implicit solve. Note that an *acceleration*
+event here would sit between that of the stress below and that of
+centered.h, and prevent the fusion of the face velocity with
+*lean_step*. */
+
+event viscous_term (i++)
+{
+  if (betaBSD > 0. && !is_constant (mu.x)) {
+    face vector mua[];
+    bsd_viscosity (mua);
+    viscosity_explicit (u, mua, rho, - dt);
+    face vector muv = mu;
+    foreach_face()
+      muv.x[] += mua.x[];
+  }
+}
+
 /**
 ## Divergence of the viscoelastic stress tensor
 
@@ -924,11 +1867,16 @@ $$
 The normal stress gradient (e.g. $\partial_x T_{xx}$) is computed directly 
 from cell-centered values. The shear stress gradients (e.g. $\partial_y T_{xy}$) 
 are computed using vertex-averaged values to avoid checkerboard instabilities.
+
+With *lean_step*, if this is the last term added to the acceleration,
+the face velocity field is built in the same sweeps (see
+[centered.h](../basilisk/src/navier-stokes/centered.h)).
 */
 
 event acceleration (i++)
 {
   face vector av = a;
+  bool fuse = uf_fusable (_ev);
 
 #if dimension == 2
   // 2D implementation
@@ -942,6 +1890,8 @@ event acceleration (i++)
       
       av.x[] += (shearX + gradX_T11)*alpha.x[]/(sq(fm.x[])*Delta);
     }
+    if (fuse)
+      uf.x[] = face_velocity_x (point);
   }
   
   foreach_face(y) {
@@ -954,6 +1904,8 @@ event acceleration (i++)
       
       av.y[] += (shearY + gradY_T22)*alpha.y[]/(sq(fm.y[])*Delta);
     }
+    if (fuse)
+      uf.y[] = face_velocity_y (point);
   }
 
 #elif dimension == 3
@@ -971,6 +1923,8 @@ event acceleration (i++)
       
       av.x[] += (shearY + shearZ + gradX_T11)*alpha.x[]/(sq(fm.x[])*Delta);
     }
+    if (fuse)
+      uf.x[] = face_velocity_x (point);
   }
 
   foreach_face(y) {
@@ -986,6 +1940,8 @@ event acceleration (i++)
       
       av.y[] += (shearX + shearZ + gradY_T22)*alpha.y[]/(sq(fm.y[])*Delta);
     }
+    if (fuse)
+      uf.y[] = face_velocity_y (point);
   }
 
   foreach_face(z) {
@@ -1001,7 +1957,10 @@ event acceleration (i++)
       
       av.z[] += (shearX + shearY + gradZ_T33)*alpha.z[]/(sq(fm.z[])*Delta);
     }
+    if (fuse)
+      uf.z[] = face_velocity_z (point);
   }
 #endif
+  uf_built = fuse;
 }
 
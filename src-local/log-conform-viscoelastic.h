@@ -533,21 +533,34 @@ calculated directly from center values of cells sharing the face. The
 other one is harder. It will be computed from vertex values. The
 vertex values are obtained by averaging centered values.  Note that as
 a result of the vertex averaging cells `[]` and `[-1,0]` are not
-involved in the computation of shear. */
+involved in the computation of shear.
+
+With *lean_step*, if this is the last term added to the acceleration,
+the face velocity field is built in the same sweeps (see
+[centered.h](../basilisk/src/navier-stokes/centered.h)). With axi, the
+$y$-component is rebuilt after the hoop stress is added. */
 
 event acceleration (i++)
 {
   face vector av = a;
-  foreach_face()
+  bool fuse = uf_fusable (_ev);
+  foreach_face() {
     if (fm.x[] > 1e-20) {
       double shear = (tau_p.x.y[0,1]*cm[0,1] + tau_p.x.y[-1,1]*cm[-1,1] -
 		      tau_p.x.y[0,-1]*cm[0,-1] - tau_p.x.y[-1,-1]*cm[-1,-1])/4.;
       av.x[] += (shear + cm[]*tau_p.x.x[] - cm[-1]*tau_p.x.x[-1])*
 	alpha.x[]/(sq(fm.x[])*Delta);
     }
+    if (fuse)
+      uf.x[] = face_velocity_x (point);
+  }
 #if AXI
-  foreach_face(y)
+  foreach_face(y) {
     if (y > 0.)
       av.y[] -= (tau_qq[] + tau_qq[0,-1])*alpha.y[]/sq(y)/2.;
+    if (fuse)
+      uf.y[] = face_velocity_y (point);
+  }
 #endif
+  uf_built = fuse;
 }
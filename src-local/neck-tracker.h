@@ -0,0 +1,170 @@
+/** Title: neck-tracker.h
+# Version: 1.0
+# Main feature: In-situ tracking of the neck and of the filament of a liquid thread.
+
+# Author: Vatsal Sanjay
+# vatsalsanjay@gmail.com
+# Physics of Fluids
+# Updated: Oct 18, 2026
+
+# change log: Oct 18, 2026 (v1.0)
+- neck_tracker(): neck radius and position, filament length and the fields at the neck, written as a time series.
+
+# Why?
+For pinch-off studies, the minimum neck radius, the length of the
+filament and the polymer stress at the neck are needed at a much
+higher cadence than the snapshots. Extracting them from thousands of
+full dumps is slow and wasteful. Here they are computed at every call
+from the VOF facets, with MPI reductions, and appended to a small text
+file. Snapshots can then be written at a coarse restart cadence.
+
+# Definitions
+The thread is along the $x$-axis, centred on $y = z = 0$ (the axis of
+symmetry with [axi.h](http://basilisk.fr/src/axi.h)). In each
+interfacial cell, the centroid of the VOF facet is a point of the
+interface at a distance $r$ from the axis ($r = y$ in 2D and axi,
+$\sqrt{y^2 + z^2}$ in 3D). Only the facets whose normal is mostly
+radial are kept: this excludes the caps of the drops and of the
+retracting ends of the filament.
+
+* the neck radius *rneck* is the smallest $r$, at the position *xneck*;
+* the filament length *lfilament* is the axial extent of the facets
+  with $r <$ *filament* $\times$ *rneck*;
+* for each field of *list*, the liquid-weighted mean and the maximum
+  over the cells of the cross-section through *xneck* which contain
+  liquid.
+
+# Usage
+
+~~~literatec
+#include "../src-local/neck-tracker.h"
+
+event neckTracking (i++) {
+  neck_tracker (f, (scalar *){T11, A11}, "neck.dat");
+}
+~~~
+
+Each line of the file is `t rneck xneck lfilament` followed by the
+mean and the maximum of each field. Fields are *nodata* when there is
+no interface.
+*/
+
+#include "fractions.h"
+
+typedef struct {
+  double rneck, xneck, lfilament;
+} Neck;
+
+/**
+The centroid *p* of the facet of an interfacial cell, its distance to
+the axis and whether its normal is mostly radial. */
+
+static bool neck_facet (Point point, scalar c, coord * p, double * r)
+{
+  coord n = interface_normal (point, c), o = {0., 0., 0.};
+  double alpha = plane_alpha (c[], n);
+  plane_area_center (n, alpha, &o);
+  p->x = x + o.x*Delta, p->y = y + o.y*Delta;
+#if dimension == 3
+  p->z = z + o.z*Delta;
+  *r = sqrt (sq(p->y) + sq(p->z));
+  double nr = *r > 0. ? (n.y*p->y + n.z*p->z)/(*r) : 0.;
+#else
+  *r = fabs (p->y);
+  double nr = n.y;
+#endif
+  return fabs(n.x) < fabs(nr);
+}
+
+/**
+## *neck_tracker()*
+
+*c* is the volume fraction of the liquid, *list* the fields sampled at
+the neck and *file* the name of the time series (written by the master
+process, appended to after the first timestep). *filament* sets the
+radius, relative to the neck radius, below which the thread belongs to
+the filament. */
+
+trace
+Neck neck_tracker (scalar c, scalar * list = NULL,
+		   const char * file = "neck.dat", double filament = 2.)
+{
+  Neck neck = {HUGE, nodata, nodata};
+
+  double rneck = HUGE;
+  foreach (reduction(min:rneck))
+    if (c[] > 1e-6 && c[] < 1. - 1e-6) {
+      coord p;
+      double r;
+      if (neck_facet (point, c, &p, &r) && r < rneck)
+	rneck = r;
+    }
+
+  int n = list_len (list);
+  double mean[max(n,1)], smax[max(n,1)];
+  for (int k = 0; k < n; k++)
+    mean[k] = smax[k] = nodata;
+
+  if (rneck < HUGE) {
+    double xneck = HUGE, xmin = HUGE, xmax = - HUGE;
+    foreach (reduction(min:xneck) reduction(min:xmin) reduction(max:xmax))
+      if (c[] > 1e-6 && c[] < 1. - 1e-6) {
+	coord p;
+	double r;
+	if (neck_facet (point, c, &p, &r)) {
+	  if (r == rneck && p.x < xneck)
+	    xneck = p.x;
+	  if (r < filament*rneck) {
+	    if (p.x < xmin) xmin = p.x;
+	    if (p.x > xmax) xmax = p.x;
+	  }
+	}
+      }
+    neck.rneck = rneck, neck.xneck = xneck, neck.lfilament = xmax - xmin;
+
+    /**
+    The fields are averaged over the liquid in the cross-section. */
+
+    double vol = 0.;
+    for (int k = 0; k < n; k++)
+      mean[k] = 0., smax[k] = - HUGE;
+    foreach (reduction(+:vol) reduction(+:mean[:n]) reduction(max:smax[:n]))
+      if (fabs(x - xneck) <= Delta/2. && c[] > 0.) {
+	vol += c[]*dv();
+	int k = 0;
+	for (scalar s in list) {
+	  mean[k] += c[]*dv()*s[];
+	  if (s[] > smax[k])
+	    smax[k] = s[];
+	  k++;
+	}
+      }
+    for (int k = 0; k < n; k++) {
+      mean[k] = vol > 0. ? mean[k]/vol : nodata;
+      if (smax[k] == - HUGE)
+	smax[k] = nodata;
+    }
+  }
+
+  if (pid() == 0) {
+    FILE * fp = fopen (file, iter == 0 ? "w" : "a");
+    if (fp == NULL) {
+      perror (file);
+      exit (1);
+    }
+    if (iter == 0) {
+      fputs ("# t rneck xneck lfilament", fp);
+      for (scalar s in list)
+	fprintf (fp, " %s_mean %s_max", s.name, s.name);
+      fputc ('\n', fp);
+    }
+    fprintf (fp, "%g %g %g %g", t,
+	     neck.rneck < HUGE ? neck.rneck : nodata, neck.xneck, neck.lfilament);
+    for (int k = 0; k < n; k++)
+      fprintf (fp, " %g %g", mean[k], smax[k]);
+    fputc ('\n', fp);
+    fclose (fp);
+  }
+
+  return neck;
+}
@@ -0,0 +1,289 @@
+/** Title: output-vtu.h
+# Version: 1.0
+# Main feature: Parallel binary VTK XML output of the leaf cells of an adaptive quadtree/octree.
+
+# Author: Vatsal Sanjay
+# vatsalsanjay@gmail.com
+# Physics of Fluids
+# Updated: Oct 18, 2026
+
+# change log: Oct 18, 2026 (v1.0)
+- First version: VTK XML unstructured grid (.vtu) with raw appended binary data.
+- One piece per MPI rank plus a .pvtu index written by the master process.
+
+# Why not output_vtk() or output_gfs()?
+[output_vtk()](http://basilisk.fr/src/vtk.h) interpolates onto a uniform
+ASCII grid on a single process and
+[output_gfs()](http://basilisk.fr/src/output.h) writes every cell of the
+tree (leaves and parents) in the Gerris format. Neither scales for 3D
+adaptive meshes. Here, each process writes only its local leaf cells,
+as voxels (3D) or pixels (2D), directly in the binary format that
+ParaView/VisIt read natively. No conversion scripts are needed.
+
+# Usage
+
+~~~literatec
+#include "../src-local/output-vtu.h"
+
+event writingVTU (t = 0; t += tsnap; t <= tmax) {
+  char name[80];
+  sprintf (name, "intermediate/snapshot-%5.4f", t);
+  output_vtu ((scalar *){f, p, T11, T22, T33}, (vector *){u}, name);
+}
+~~~
+
+With a single process this writes `name.vtu`. With MPI, every rank
+writes `name_XXXX.vtu` (XXXX is the rank) and rank 0 writes the index
+`name.pvtu` which must be opened in ParaView.
+*/
+
+#include <stdint.h>
+
+/**
+## Writing the appended binary blocks
+
+In the "raw" appended encoding each data array is preceded by its size
+in bytes, stored with the `header_type` of the file (here UInt64). The
+*offset* of each array in the XML header counts bytes from the first
+byte after the `_` marker of the `<AppendedData>` section. */
+
+static void vtu_write_block (FILE * fp, const void * data, uint64_t size)
+{
+  if (fwrite (&size, sizeof(uint64_t), 1, fp) < 1 ||
+      (size > 0 && fwrite (data, 1, size, fp) < size)) {
+    perror ("output_vtu(): error while writing binary data");
+    exit (1);
+  }
+}
+
+/**
+The name of a vector field is that of its x-component without the
+".x" suffix. */
+
+static char * vtu_vector_name (vector v)
+{
+  char * name = strdup (v.x.name), * s = strrchr (name, '.');
+  if (s && !strcmp (s, ".x"))
+    *s = '\0';
+  return name;
+}
+
+static void vtu_data_arrays (FILE * fp, scalar * list, vector * vlist,
+			     uint64_t * offset, long nc)
+{
+  for (scalar s in list) {
+    fprintf (fp, "        <DataArray type=\"Float64\" Name=\"%s\""
+	     " format=\"appended\" offset=\"%lu\"/>\n",
+	     s.name, (unsigned long) *offset);
+    *offset += sizeof(uint64_t) + nc*sizeof(double);
+  }
+  for (vector v in vlist) {
+    char * name = vtu_vector_name (v);
+    fprintf (fp, "        <DataArray type=\"Float64\" Name=\"%s\""
+	     " NumberOfComponents=\"3\" format=\"appended\" offset=\"%lu\"/>\n",
+	     name, (unsigned long) *offset);
+    free (name);
+    *offset += sizeof(uint64_t) + 3*nc*sizeof(double);
+  }
+}
+
+/**
+## *output_vtu()*: leaf cells in VTK XML format
+
+The arguments and their default values are:
+
+*list*
+: a list of scalar fields to write. Default is none.
+
+*vlist*
+: a list of vector fields to write (as 3-component arrays). Default is none.
+
+*name*
+: the base name of the file(s), without extension. Default is "snapshot".
+*/
+
+trace
+void output_vtu (scalar * list = NULL,
+		 vector * vlist = NULL,
+		 const char * name = "snapshot")
+{
+  char fname[strlen(name) + 16];
+  if (npe() > 1)
+    sprintf (fname, "%s_%04d.vtu", name, pid());
+  else
+    sprintf (fname, "%s.vtu", name);
+  FILE * fp = fopen (fname, "w");
+  if (fp == NULL) {
+    perror (fname);
+    exit (1);
+  }
+
+  /**
+  The vertices of the local leaf cells are numbered once, so that
+  neighbouring cells of the same level share their points. The
+  boundary conditions of *marker* must not be applied (*noauto*): on
+  other processes they would overwrite the local numbering. */
+
+  vertex scalar marker[];
+  long nv = 0, nc = 0;
+  foreach_vertex (serial, noauto)
+    marker[] = nv++;
+  foreach (serial, noauto)
+    nc++;
+
+  double * points = malloc (3*max(nv,1)*sizeof(double));
+  foreach_vertex (serial, noauto) {
+    long k = marker[];
+    points[3*k] = x, points[3*k + 1] = y, points[3*k + 2] = z;
+  }
+
+  /**
+  Cells are written as VTK_VOXEL (3D) or VTK_PIXEL (2D), for which the
+  vertex ordering is the lexicographic ordering of the corners. */
+
+  const int nvc = 1 << dimension;
+  int64_t * connectivity = malloc (nvc*max(nc,1)*sizeof(int64_t));
+  int64_t * cell_offsets = malloc (max(nc,1)*sizeof(int64_t));
+  uint8_t * types = malloc (max(nc,1)*sizeof(uint8_t));
+  long c = 0;
+  foreach (serial, noauto) {
+    int64_t * v = connectivity + nvc*c;
+#if dimension == 1
+    v[0] = marker[], v[1] = marker[1];
+#elif dimension == 2
+    v[0] = marker[], v[1] = marker[1], v[2] = marker[0,1], v[3] = marker[1,1];
+#else // dimension == 3
+    v[0] = marker[],      v[1] = marker[1],
+    v[2] = marker[0,1],   v[3] = marker[1,1],
+    v[4] = marker[0,0,1], v[5] = marker[1,0,1],
+    v[6] = marker[0,1,1], v[7] = marker[1,1,1];
+#endif
+    cell_offsets[c] = nvc*(c + 1);
+    types[c] = dimension == 3 ? 11 : dimension == 2 ? 8 : 3;
+    c++;
+  }
+
+  /**
+  ### XML header */
+
+  fputs ("<?xml version=\"1.0\"?>\n"
+	 "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\""
+	 " byte_order=\"LittleEndian\" header_type=\"UInt64\">\n"
+	 "  <UnstructuredGrid>\n"
+	 "    <FieldData>\n"
+	 "      <DataArray type=\"Float64\" Name=\"TimeValue\""
+	 " NumberOfTuples=\"1\" format=\"ascii\">\n", fp);
+  fprintf (fp, "        %.16g\n"
+	   "      </DataArray>\n"
+	   "    </FieldData>\n", t);
+  fprintf (fp, "    <Piece NumberOfPoints=\"%ld\" NumberOfCells=\"%ld\">\n",
+	   nv, nc);
+  uint64_t offset = 0;
+  fprintf (fp, "      <Points>\n"
+	   "        <DataArray type=\"Float64\" NumberOfComponents=\"3\""
+	   " format=\"appended\" offset=\"%lu\"/>\n"
+	   "      </Points>\n", (unsigned long) offset);
+  offset += sizeof(uint64_t) + 3*nv*sizeof(double);
+  fputs ("      <Cells>\n", fp);
+  fprintf (fp, "        <DataArray type=\"Int64\" Name=\"connectivity\""
+	   " format=\"appended\" offset=\"%lu\"/>\n", (unsigned long) offset);
+  offset += sizeof(uint64_t) + nvc*nc*sizeof(int64_t);
+  fprintf (fp, "        <DataArray type=\"Int64\" Name=\"offsets\""
+	   " format=\"appended\" offset=\"%lu\"/>\n", (unsigned long) offset);
+  offset += sizeof(uint64_t) + nc*sizeof(int64_t);
+  fprintf (fp, "        <DataArray type=\"UInt8\" Name=\"types\""
+	   " format=\"appended\" offset=\"%lu\"/>\n", (unsigned long) offset);
+  offset += sizeof(uint64_t) + nc*sizeof(uint8_t);
+  fputs ("      </Cells>\n"
+	 "      <CellData>\n", fp);
+  vtu_data_arrays (fp, list, vlist, &offset, nc);
+  fputs ("      </CellData>\n"
+	 "    </Piece>\n"
+	 "  </UnstructuredGrid>\n"
+	 "  <AppendedData encoding=\"raw\">\n"
+	 "_", fp);
+
+  /**
+  ### Appended binary data
+
+  Each field is gathered in a buffer (reused for all fields) and written
+  as a single block. */
+
+  vtu_write_block (fp, points, 3*nv*sizeof(double));
+  vtu_write_block (fp, connectivity, nvc*nc*sizeof(int64_t));
+  vtu_write_block (fp, cell_offsets, nc*sizeof(int64_t));
+  vtu_write_block (fp, types, nc*sizeof(uint8_t));
+  free (points), free (connectivity), free (cell_offsets), free (types);
+
+  double * buf = malloc (3*max(nc,1)*sizeof(double));
+  for (scalar s in list) {
+    long c = 0;
+    foreach (serial)
+      buf[c++] = s[];
+    vtu_write_block (fp, buf, nc*sizeof(double));
+  }
+  for (vector v in vlist) {
+    long c = 0;
+    foreach (serial) {
+      buf[3*c] = v.x[];
+#if dimension >= 2
+      buf[3*c + 1] = v.y[];
+#else
+      buf[3*c + 1] = 0.;
+#endif
+#if dimension >= 3
+      buf[3*c + 2] = v.z[];
+#else
+      buf[3*c + 2] = 0.;
+#endif
+      c++;
+    }
+    vtu_write_block (fp, buf, 3*nc*sizeof(double));
+  }
+  free (buf);
+
+  fputs ("\n  </AppendedData>\n"
+	 "</VTKFile>\n", fp);
+  fclose (fp);
+
+  /**
+  ### Parallel index
+
+  With MPI, the master process writes the `.pvtu` file listing the
+  pieces. The piece names are relative to the location of the index. */
+
+  if (npe() > 1 && pid() == 0) {
+    char pname[strlen(name) + 8];
+    sprintf (pname, "%s.pvtu", name);
+    FILE * fp = fopen (pname, "w");
+    if (fp == NULL) {
+      perror (pname);
+      exit (1);
+    }
+    const char * base = strrchr (name, '/');
+    base = base ? base + 1 : name;
+    fputs ("<?xml version=\"1.0\"?>\n"
+	   "<VTKFile type=\"PUnstructuredGrid\" version=\"1.0\""
+	   " byte_order=\"LittleEndian\" header_type=\"UInt64\">\n"
+	   "  <PUnstructuredGrid GhostLevel=\"0\">\n"
+	   "    <PPoints>\n"
+	   "      <PDataArray type=\"Float64\" NumberOfComponents=\"3\"/>\n"
+	   "    </PPoints>\n"
+	   "    <PCellData>\n", fp);
+    for (scalar s in list)
+      fprintf (fp, "      <PDataArray type=\"Float64\" Name=\"%s\"/>\n",
+	       s.name);
+    for (vector v in vlist) {
+      char * vname = vtu_vector_name (v);
+      fprintf (fp, "      <PDataArray type=\"Float64\" Name=\"%s\""
+	       " NumberOfComponents=\"3\"/>\n", vname);
+      free (vname);
+    }
+    fputs ("    </PCellData>\n", fp);
+    for (int i = 0; i < npe(); i++)
+      fprintf (fp, "    <Piece Source=\"%s_%04d.vtu\"/>\n", base, i);
+    fputs ("  </PUnstructuredGrid>\n"
+	   "</VTKFile>\n", fp);
+    fclose (fp);
+  }
+}
@@ -0,0 +1,583 @@
+/** Title: snapshot-store.h
+# Version: 1.1
+# Main feature: Content-addressed snapshot store: unchanged subtrees and fields are written only once across snapshots.
+
+# Author: Vatsal Sanjay
+# vatsalsanjay@gmail.com
+# Physics of Fluids
+# Updated: Oct 18, 2026
+
+# change log: Oct 18, 2026 (v1.0)
+- dump_store() and restore_store(): snapshots split in chunks per coarse subtree and per field, one manifest per snapshot.
+- restore_store() falls back to [restore_sections()](dump-sections.h) (and hence to *restore()*) for other snapshots.
+
+# change log: Oct 18, 2026 (v1.1)
+- restore_store (..., maxlevel = L): the tree is only rebuilt down to level L, for previews.
+
+# Why?
+Successive snapshots of a long campaign are mostly identical: the tree
+is only refined near the interface, and large regions (quiescent gas
+where $\mathbf{A} = \mathbf{I}$, the bulk of each phase where *f* is
+constant) do not change from one snapshot to the next. Yet
+[dump()](http://basilisk.fr/src/output.h) and
+[dump_sections()](dump-sections.h) write every byte of every snapshot.
+
+Here, the topology and each field (as in *dump_sections()*, in the
+order of *foreach_cell()*, with the restricted values) are cut into
+chunks:
+
+* chunk 0 holds the cells coarser than *level*,
+* every cell of *level* starts a chunk holding its whole subtree.
+
+Refining or coarsening a region only changes the chunks of its
+subtrees. Each chunk is stored in `chunks/` (next to the manifest)
+under the name of a 64-bit hash of its content and its size, and is
+written only if no earlier snapshot has produced it. The snapshot
+itself is a small manifest: the header, the field table, the number of
+cells of each chunk and the hashes of all the chunks.
+
+# Usage
+
+~~~literatec
+#include "../src-local/snapshot-store.h"
+
+event writingFiles (t = 0; t += tsnap; t <= tmax) {
+  sprintf (nameOut, "intermediate/snapshot-%5.4f", t);
+  dump_store (file = nameOut);
+}
+~~~
+
+and in the post-processing tool
+
+~~~literatec
+restore_store (file = filename, list = {f});
+~~~
+
+Only the chunks of the requested fields are read. The `chunks/`
+directory is shared by all the manifests of the same directory and
+must be copied with them. As for *dump_sections()*, writing works with
+MPI (the chunks are assembled and written by the master process) and
+restoring is serial.
+*/
+
+#include <stdint.h>
+#include <sys/stat.h>
+#include "dump-sections.h"
+
+#define STORE_MAGIC "BSTORE01"
+
+struct StoreHeader {
+  char magic[8];
+  double t;
+  long ncells;
+  int i, depth, npe, version, nfields, dim, level, nchunks;
+  double origin[4];
+};
+
+static const int store_version = 261020;
+
+/**
+## Chunks
+
+The manifest lists the cells in the order of *foreach_cell()*, as a
+sequence of leaf flags. The chunk of each cell follows from its level,
+given by a *SectionsCursor*. */
+
+typedef struct {
+  SectionsCursor c;
+  int clevel, chunks;
+} StoreParser;
+
+static int store_owner (StoreParser * p)
+{
+  if (p->c.level < p->clevel)
+    return 0;
+  if (p->c.level == p->clevel)
+    p->chunks++;
+  return p->chunks;
+}
+
+/**
+The cells of a section are reordered chunk by chunk (*gather* is
+false) or back in the order of *foreach_cell()* (*gather* is true).
+*start* is the index of the first cell of each chunk. */
+
+static void store_permute (const int * owner, const long * start, int nchunks,
+			   long ncells, size_t size,
+			   const char * in, char * out, bool gather)
+{
+  long cursor[nchunks];
+  memcpy (cursor, start, nchunks*sizeof(long));
+  for (long i = 0; i < ncells; i++) {
+    long j = cursor[owner[i]]++;
+    if (gather)
+      memcpy (out + i*size, in + j*size, size);
+    else
+      memcpy (out + j*size, in + i*size, size);
+  }
+}
+
+/**
+The 64-bit FNV-1a hash. Together with the size of the chunk, which is
+part of its name, collisions are negligible for any realistic number
+of chunks. */
+
+static uint64_t store_hash (const void * data, size_t n)
+{
+  const unsigned char * c = data;
+  uint64_t h = 14695981039346656037ULL;
+  for (size_t i = 0; i < n; i++)
+    h = (h ^ c[i])*1099511628211ULL;
+  return h;
+}
+
+/**
+Chunks are spread over 256 subdirectories of `chunks/`, named after
+the first byte of their hash. */
+
+static void store_chunk_path (char * path, const char * dir,
+			      uint64_t hash, size_t bytes)
+{
+  sprintf (path, "%s/chunks/%02x/%016llx-%lu", dir, (unsigned) (hash >> 56),
+	   (unsigned long long) hash, (unsigned long) bytes);
+}
+
+static void store_mkdir (const char * path)
+{
+  struct stat st;
+  if (mkdir (path, 0755) && stat (path, &st)) {
+    perror (path);
+    exit (1);
+  }
+}
+
+static char * store_dir (const char * file)
+{
+  char * dir = strdup (file), * s = strrchr (dir, '/');
+  if (s)
+    *s = '\0';
+  else
+    strcpy (dir, ".");
+  return dir;
+}
+
+/**
+A chunk is written under a temporary name and renamed once complete,
+so that an interrupted run never leaves a truncated chunk which later
+snapshots would reference. Returns the number of bytes written. */
+
+static size_t store_write_chunk (const char * dir, const char * data,
+				 size_t bytes, uint64_t * hash)
+{
+  *hash = store_hash (data, bytes);
+  char path[strlen(dir) + 48];
+  store_chunk_path (path, dir, *hash, bytes);
+  struct stat st;
+  if (stat (path, &st) == 0)
+    return 0;
+  char sub[strlen(dir) + 16];
+  sprintf (sub, "%s/chunks/%02x", dir, (unsigned) (*hash >> 56));
+  store_mkdir (sub);
+  char name[strlen(path) + 2];
+  sprintf (name, "%s~", path);
+  FILE * fp = fopen (name, "w");
+  if (fp == NULL) {
+    perror (name);
+    exit (1);
+  }
+  if (bytes > 0 && fwrite (data, 1, bytes, fp) < bytes) {
+    perror ("dump_store(): error while writing chunk");
+    exit (1);
+  }
+  fclose (fp);
+  rename (name, path);
+  return bytes;
+}
+
+static void store_read_chunk (const char * dir, uint64_t hash,
+			      size_t bytes, char * data)
+{
+  char path[strlen(dir) + 48];
+  store_chunk_path (path, dir, hash, bytes);
+  FILE * fp = fopen (path, "r");
+  if (fp == NULL) {
+    perror (path);
+    exit (1);
+  }
+  if (bytes > 0 && fread (data, 1, bytes, fp) < bytes) {
+    fprintf (ferr, "restore_store(): error: truncated chunk %s\n", path);
+    exit (1);
+  }
+  fclose (fp);
+}
+
+/**
+## Gathering a section
+
+The whole section of *s* (the leaf flags if *s* is -1) is assembled
+on the master process, in the order of *foreach_cell()*. With MPI,
+each process sends its local cells together with their Z-ordering
+*index*. */
+
+static void store_value (Point point, scalar s, char * p)
+{
+  if (s.i < 0)
+    *((unsigned char *) p) = is_leaf(cell);
+  else if (s.single)
+    *((float *) p) = s[];
+  else
+    *((double *) p) = s[];
+}
+
+static char * store_gather (scalar s, size_t size, long ncells, scalar index)
+{
+#if _MPI
+  long n = 0;
+  foreach_cell() {
+    if (is_local(cell))
+      n++;
+    if (is_leaf(cell))
+      continue;
+  }
+  long * idx = malloc (max(n,1)*sizeof(long));
+  char * val = malloc (max(n,1)*size);
+  n = 0;
+  foreach_cell() {
+    if (is_local(cell)) {
+      idx[n] = index[];
+      store_value (point, s, val + (n++)*size);
+    }
+    if (is_leaf(cell))
+      continue;
+  }
+
+  int count = n, counts[npe()], displs[npe()], bcounts[npe()], bdispls[npe()];
+  MPI_Gather (&count, 1, MPI_INT, counts, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  long total = 0;
+  if (pid() == 0)
+    for (int j = 0; j < npe(); j++) {
+      displs[j] = total, total += counts[j];
+      bcounts[j] = counts[j]*size, bdispls[j] = displs[j]*size;
+    }
+  long * ridx = pid() == 0 ? malloc (max(total,1)*sizeof(long)) : NULL;
+  char * rval = pid() == 0 ? malloc (max(total,1)*size) : NULL;
+  MPI_Gatherv (idx, count, MPI_LONG, ridx, counts, displs, MPI_LONG,
+	       0, MPI_COMM_WORLD);
+  MPI_Gatherv (val, count*size, MPI_BYTE, rval, bcounts, bdispls, MPI_BYTE,
+	       0, MPI_COMM_WORLD);
+  free (idx), free (val);
+  char * buf = NULL;
+  if (pid() == 0) {
+    buf = malloc (max(ncells,1)*size);
+    for (long j = 0; j < total; j++)
+      memcpy (buf + ridx[j]*size, rval + j*size, size);
+    free (ridx), free (rval);
+  }
+  return buf;
+#else
+  char * buf = malloc (max(ncells,1)*size), * p = buf;
+  foreach_cell() {
+    store_value (point, s, p);
+    p += size;
+    if (is_leaf(cell))
+      continue;
+  }
+  return buf;
+#endif
+}
+
+/**
+## *dump_store()*
+
+The arguments are the name of the manifest *file*, the *list* of
+fields (face fields and fields marked *nodump* are skipped) and the
+*level* of the roots of the chunked subtrees. Returns the number of
+bytes of new chunks (on the master process), which measures the
+write volume of the snapshot. */
+
+trace
+long dump_store (const char * file = "dump",
+		 scalar * list = all,
+		 int level = dimension == 2 ? 5 : 3)
+{
+  scalar * slist = dump_list (list);
+  struct StoreHeader header = { STORE_MAGIC, t, 0, iter, depth(), npe(),
+				store_version, list_len (slist), dimension,
+				level, 1, {X0, Y0, Z0, L0} };
+
+  scalar index = {-1};
+#if _MPI
+  scalar zindex[];
+  index = zindex;
+  header.ncells = z_indexing (index, false) + 1;
+  mpi_all_reduce (header.ncells, MPI_LONG, MPI_MAX);
+#else
+  foreach_cell() {
+    header.ncells++;
+    if (is_leaf(cell))
+      continue;
+  }
+#endif
+
+  /**
+  The chunk of each cell follows from the topology section. */
+
+  char * dir = store_dir (file);
+  char * flags = store_gather ((scalar){-1}, sizeof(unsigned char),
+			       header.ncells, index);
+  int * owner = NULL;
+  long * start = NULL;
+  FILE * fp = NULL;
+  if (pid() == 0) {
+    char chunks[strlen(dir) + 8];
+    sprintf (chunks, "%s/chunks", dir);
+    store_mkdir (chunks);
+
+    owner = malloc (max(header.ncells,1)*sizeof(int));
+    StoreParser p = { .clevel = level, .chunks = 0 };
+    p.c.level = 0, p.c.left[0] = 1;
+    for (long i = 0; i < header.ncells; i++) {
+      owner[i] = store_owner (&p);
+      sections_advance (&p.c, flags[i]);
+    }
+    header.nchunks = p.chunks + 1;
+    start = calloc (header.nchunks + 1, sizeof(long));
+    for (long i = 0; i < header.ncells; i++)
+      start[owner[i] + 1]++;
+    for (int k = 0; k < header.nchunks; k++)
+      start[k + 1] += start[k];
+
+    fp = fopen (file, "w");
+    if (fp == NULL) {
+      perror (file);
+      exit (1);
+    }
+  }
+
+  /**
+  Each section is cut into chunks and hashed: the hashes are the rows
+  (topology first, then one per field) of the chunk table of the
+  manifest. */
+
+  uint64_t * hashes = NULL;
+  long written = 0;
+  for (int k = -1; k < header.nfields; k++) {
+    scalar s = k < 0 ? (scalar){-1} : slist[k];
+    size_t size = k < 0 ? sizeof(unsigned char) : sections_size (s);
+    char * section = k < 0 ? flags : store_gather (s, size, header.ncells, index);
+    if (pid() == 0) {
+      char * chunked = malloc (max(header.ncells,1)*size);
+      store_permute (owner, start, header.nchunks, header.ncells, size,
+		     section, chunked, false);
+      hashes = realloc (hashes, (k + 2)*header.nchunks*sizeof(uint64_t));
+      uint64_t * row = hashes + (k + 1)*header.nchunks;
+      for (int c = 0; c < header.nchunks; c++)
+	written += store_write_chunk (dir, chunked + start[c]*size,
+				      (start[c + 1] - start[c])*size, row + c);
+      free (chunked);
+    }
+    free (section);
+  }
+
+  /**
+  The manifest is written last, so that all its chunks exist. */
+
+  if (pid() == 0) {
+    long ncells[header.nchunks];
+    for (int c = 0; c < header.nchunks; c++)
+      ncells[c] = start[c + 1] - start[c];
+    if (fwrite (&header, sizeof(struct StoreHeader), 1, fp) < 1) {
+      perror ("dump_store(): error while writing header");
+      exit (1);
+    }
+    for (scalar s in slist) {
+      unsigned len = strlen(s.name), size = sections_size (s);
+      if (fwrite (&len, sizeof(unsigned), 1, fp) < 1 ||
+	  fwrite (s.name, sizeof(char), len, fp) < len ||
+	  fwrite (&size, sizeof(unsigned), 1, fp) < 1) {
+	perror ("dump_store(): error while writing the field table");
+	exit (1);
+      }
+    }
+    size_t nh = (header.nfields + 1)*header.nchunks;
+    if (fwrite (ncells, sizeof(long), header.nchunks, fp) < header.nchunks ||
+	fwrite (hashes, sizeof(uint64_t), nh, fp) < nh) {
+      perror ("dump_store(): error while writing the chunk table");
+      exit (1);
+    }
+    fclose (fp);
+    free (owner), free (start), free (hashes);
+  }
+  free (dir);
+  free (slist);
+  return written;
+}
+
+/**
+## *restore_store()*
+
+Restores the fields of *list* (default *all*) from the manifest
+*file*. Fields of *list* which are not in the snapshot and all the
+other fields are reset to zero. As for *restore_sections()*, the tree
+is restored down to *maxlevel* (default all levels): whole chunks are
+still read, but deeper cells are neither allocated nor filled. If
+*file* is not a manifest, this falls back to *restore_sections()*.
+Returns false if the file cannot be opened. */
+
+trace
+bool restore_store (const char * file = "dump",
+		    scalar * list = NULL,
+		    int maxlevel = -1)
+{
+  FILE * fp = fopen (file, "r");
+  if (fp == NULL)
+    return false;
+
+  struct StoreHeader header;
+  if (fread (&header, sizeof(header), 1, fp) < 1 ||
+      strncmp (header.magic, STORE_MAGIC, 8)) {
+    fclose (fp);
+    return restore_sections (file = file, list = list, maxlevel = maxlevel);
+  }
+  if (header.version != store_version) {
+    fprintf (ferr,
+	     "restore_store(): error: file version mismatch: "
+	     "%d (file) != %d (code)\n",
+	     header.version, store_version);
+    exit (1);
+  }
+  if (header.dim != dimension) {
+    fprintf (ferr,
+	     "restore_store(): error: dimension mismatch: "
+	     "%d (file) != %d (code)\n",
+	     header.dim, dimension);
+    exit (1);
+  }
+  not_mpi_compatible();
+  if (maxlevel < 0 || maxlevel > header.depth)
+    maxlevel = header.depth;
+
+  /**
+  The field table is matched against the requested fields. */
+
+  scalar * slist = dump_list (list ? list : all), * input = NULL;
+  int * rows = NULL;
+  unsigned * sizes = NULL;
+  int n = 0;
+  for (int k = 0; k < header.nfields; k++) {
+    unsigned len, size;
+    if (fread (&len, sizeof(unsigned), 1, fp) < 1) {
+      fprintf (ferr, "restore_store(): error: expecting len\n");
+      exit (1);
+    }
+    char name[len + 1];
+    if (fread (name, sizeof(char), len, fp) < len ||
+	fread (&size, sizeof(unsigned), 1, fp) < 1) {
+      fprintf (ferr, "restore_store(): error: expecting field table\n");
+      exit (1);
+    }
+    name[len] = '\0';
+    for (scalar s in slist)
+      if (!strcmp (s.name, name)) {
+	input = list_append (input, s);
+	rows = realloc (rows, (n + 1)*sizeof(int));
+	sizes = realloc (sizes, (n + 1)*sizeof(unsigned));
+	rows[n] = k + 1, sizes[n++] = size;
+	break;
+      }
+  }
+  free (slist);
+
+  long ncells[header.nchunks], start[header.nchunks + 1];
+  size_t nh = (header.nfields + 1)*header.nchunks;
+  uint64_t * hashes = malloc (nh*sizeof(uint64_t));
+  if (fread (ncells, sizeof(long), header.nchunks, fp) < header.nchunks ||
+      fread (hashes, sizeof(uint64_t), nh, fp) < nh) {
+    fprintf (ferr, "restore_store(): error: expecting chunk table\n");
+    exit (1);
+  }
+  fclose (fp);
+  start[0] = 0;
+  for (int c = 0; c < header.nchunks; c++)
+    start[c + 1] = start[c] + ncells[c];
+
+  /**
+  The topology is reassembled first: the chunk of each cell is only
+  known once the flags of the cells before it have been read. */
+
+  char * dir = store_dir (file);
+  char * chunked = malloc (max(header.ncells,1)*sizeof(double));
+  for (int c = 0; c < header.nchunks; c++)
+    store_read_chunk (dir, hashes[c], ncells[c], chunked + start[c]);
+  int * owner = malloc (max(header.ncells,1)*sizeof(int));
+  unsigned char * flags = malloc (max(header.ncells,1));
+  long cursor[header.nchunks];
+  memcpy (cursor, start, header.nchunks*sizeof(long));
+  long * kept = malloc (max(header.ncells,1)*sizeof(long)), nk = 0;
+  StoreParser p = { .clevel = header.level, .chunks = 0 };
+  p.c.level = 0, p.c.left[0] = 1;
+  for (long i = 0; i < header.ncells; i++) {
+    if (p.c.level <= maxlevel)
+      kept[nk++] = i;
+    owner[i] = store_owner (&p);
+    flags[i] = chunked[cursor[owner[i]]++];
+    sections_advance (&p.c, flags[i]);
+  }
+
+  /**
+  The tree is rebuilt from the kept cells, as in *restore_sections()*. */
+
+#if TREE
+  init_grid (1);
+  foreach_cell() {
+    cell.pid = pid();
+    cell.flags |= active;
+  }
+  tree->dirty = true;
+#else // multigrid
+  init_grid (1 << maxlevel);
+#endif
+  origin (header.origin[0], header.origin[1], header.origin[2]);
+  size (header.origin[3]);
+
+  scalar * listm = is_constant(cm) ? NULL : (scalar *){fm};
+  long j = 0;
+#if TREE
+  foreach_cell() {
+    if (!flags[kept[j++]] && is_leaf(cell) && level < maxlevel)
+      refine_cell (point, listm, 0, NULL);
+    if (is_leaf(cell))
+      continue;
+  }
+#endif
+  free (flags);
+
+  /**
+  Only the chunks of the requested fields are read. */
+
+  char * section = malloc (max(header.ncells,1)*sizeof(double));
+  int k = 0;
+  for (scalar s in input) {
+    unsigned size = sizes[k];
+    uint64_t * row = hashes + rows[k++]*header.nchunks;
+    for (int c = 0; c < header.nchunks; c++)
+      store_read_chunk (dir, row[c], ncells[c]*size, chunked + start[c]*size);
+    store_permute (owner, start, header.nchunks, header.ncells, size,
+		   chunked, section, true);
+    j = 0;
+    foreach_cell() {
+      long i = kept[j++];
+      s[] = size == sizeof(float) ?
+	((float *) section)[i] : ((double *) section)[i];
+      if (is_leaf(cell))
+	continue;
+    }
+  }
+  free (section), free (chunked), free (owner), free (hashes), free (kept);
+  free (rows), free (sizes), free (dir);
+
+  sections_restored (input, listm, header.t, header.i);
+  free (input);
+
+  return true;
+}
@@ -1,9 +1,10 @@
 /**
  * Modification by Vatsal Sanjay 
- * Version 2.0, Oct 17, 2024
+ * Version 2.1, Oct 18, 2026
 
 # Changelog
 - Oct 17, 2024: added support for VE simulations.
+- Oct 18, 2026: support for several VOF tracers in *interfaces* (e.g. [no-coalescence.h](http://basilisk.fr/src/no-coalescence.h)).
 
 # Brief history
 - v1.0 is the vanilla Basilisk code for two-phase flows: http://basilisk.fr/src/two-phase.h + http://basilisk.fr/src/two-phase-generic.h
@@ -75,8 +76,37 @@ scalar sf[];
 # define sf f
 #endif
 
+/**
+## Several VOF tracers
+
+With [no-coalescence.h](http://basilisk.fr/src/no-coalescence.h) (foams,
+emulsions), the interfaces are carried by several VOF tracers stored
+in the *interfaces* list and *f* is not advected anymore. All the
+properties below (including the polymeric ones) are computed from the
+summed volume fraction, so that a single set of conformation fields
+([log-conform-viscoelastic-scalar-3D.h](log-conform-viscoelastic-scalar-3D.h))
+is shared by all the tracers: the cost of the viscoelastic part does
+not depend on their number.
+
+*f* is updated here, whatever the order in which the files are
+included. With the default single tracer, nothing is done. */
+
+static void interfaces_sum ()
+{
+  if (!interfaces || (interfaces[0].i == f.i && interfaces[1].i < 0))
+    return;
+  foreach() {
+    double fsum = 0.;
+    for (scalar c in interfaces)
+      fsum += c[];
+    f[] = clamp(fsum, 0., 1.);
+  }
+}
+
 event tracer_advection (i++) {
 
+  interfaces_sum();
+
   /**
   When using smearing of the density jump, we initialise *sf* with the
   vertex-average of *f*. */
@@ -0,0 +1,248 @@
+/** Title: costAccuracy.h
+# Cost versus accuracy of the constitutive solvers
+
+# Author: Vatsal Sanjay
+# vatsalsanjay@gmail.com
+# Physics of Fluids
+# Updated: Oct 18, 2026
+
+Shared part of the Oldroyd-B validation cases
+[costAccuracyPoiseuille.c](costAccuracyPoiseuille.c) and
+[costAccuracyLid.c](costAccuracyLid.c), adapted from
+[poiseuille-oldroydb.c](../basilisk/src/test/poiseuille-oldroydb.c) and
+[lid-oldroydb.c](../basilisk/src/test/lid-oldroydb.c). Each run reports
+its error together with its cost, so that every performance option is
+judged on time-to-solution at fixed accuracy.
+[costAccuracy.sh](costAccuracy.sh) runs the whole matrix.
+
+# Variants
+The constitutive solver is selected at compile time:
+
+* `-DTENSOR=1`: [log-conform-viscoelastic.h](../src-local/log-conform-viscoelastic.h) (2D),
+* `-DSCALAR2D=1`: [log-conform-viscoelastic-scalar-2D.h](../src-local/log-conform-viscoelastic-scalar-2D.h) (2D),
+* `-DFENE_P=1` or `-DGIESEKUS=1`: [fene-p-3D.h](../src-local/fene-p-3D.h)
+  with $L^2 = 10^8$ or [giesekus-3D.h](../src-local/giesekus-3D.h) with
+  $\alpha = 0$, both of which reduce to Oldroyd-B (3D),
+* otherwise [log-conform-viscoelastic-scalar-3D.h](../src-local/log-conform-viscoelastic-scalar-3D.h).
+
+The cases are 2D by default and 3D with `-grid=octree`.
+
+# Options
+Runtime options are given as `key=value` arguments:
+
+* *level*: the grid is uniform, with $2^{level}$ cells per direction,
+* *refine*: the quarter of the domain next to the top boundary (the
+  lid or the wall of the channel) is refined by *refine* more levels
+  (trees only), see *ca_refine()*,
+* *tmax*: the end of the comparison,
+* *WiFast*: the quasi-steady path of the 3D solver (3D only),
+* *lts*: the local time stepping levels of the 3D solver (octrees
+  only; also useful without *refine*, since the update then differs
+  from the default one even though every cell is at the maximum level),
+* *lean*, *fused*, *fusedStep*: *lean_step* of the centered solver
+  (with *stokes*), the fused residual of the multigrid solver and
+  *fused_step* of the centered solver,
+* *psiDiffusion*, *betaBSD*: the implicit diffusion of $\Psi$ and the
+  both-sides diffusion stabilisation (scalar-3D solver and its FENE-P
+  and Giesekus variants). With *betaBSD*, the solvent viscosity is a
+  face field reset at every timestep, see *ca_properties()*,
+* *ref*: the reference data of the case, if any.
+
+# Report
+Each run appends one line to `costAccuracy.dat`:
+
+~~~
+case variant dim level options cells steps cellsxsteps wall errL2 errLinf
+~~~
+
+where *cellsxsteps* is the total number of cell updates, *wall* the
+wall-clock time of the run and *errL2*, *errLinf* the RMS and maximum
+errors over the sampling times (see each case).
+*/
+
+#if TENSOR
+# include "../src-local/log-conform-viscoelastic.h"
+# define VARIANT "tensor"
+#elif SCALAR2D
+# include "../src-local/log-conform-viscoelastic-scalar-2D.h"
+# define VARIANT "scalar-2D"
+#elif FENE_P
+# include "../src-local/fene-p-3D.h"
+# define VARIANT "fene-p"
+#elif GIESEKUS
+# include "../src-local/giesekus-3D.h"
+# define VARIANT "giesekus"
+#else
+# include "../src-local/log-conform-viscoelastic-scalar-3D.h"
+# define VARIANT "scalar-3D"
+#endif
+
+struct {
+  int level, refine, lts;
+  double tmax, WiFast, psiDiffusion, betaBSD, mus;
+  bool lean, fused, fusedStep;
+  const char * ref;
+  char options[256];
+  // error statistics
+  double sum2, emax;
+  long n;
+} ca = { .level = 5, .tmax = 1. };
+
+void ca_options (int argc, char const * argv[])
+{
+  for (int k = 1; k < argc; k++) {
+    int v;
+    if (!strncmp (argv[k], "ref=", 4)) {
+      ca.ref = argv[k] + 4;
+      continue;
+    }
+    if (!sscanf (argv[k], "level=%d", &ca.level) &&
+	!sscanf (argv[k], "refine=%d", &ca.refine) &&
+	!sscanf (argv[k], "tmax=%lf", &ca.tmax) &&
+	!sscanf (argv[k], "WiFast=%lf", &ca.WiFast) &&
+	!sscanf (argv[k], "psiDiffusion=%lf", &ca.psiDiffusion) &&
+	!sscanf (argv[k], "betaBSD=%lf", &ca.betaBSD) &&
+	!sscanf (argv[k], "lts=%d", &ca.lts)) {
+      if (sscanf (argv[k], "lean=%d", &v))
+	ca.lean = v;
+      else if (sscanf (argv[k], "fusedStep=%d", &v))
+	ca.fusedStep = v;
+      else if (sscanf (argv[k], "fused=%d", &v))
+	ca.fused = v;
+      else {
+	fprintf (ferr, "%s: unknown option '%s'\n", argv[0], argv[k]);
+	exit (1);
+      }
+    }
+    if (strlen (ca.options) + strlen (argv[k]) + 2 < sizeof (ca.options)) {
+      if (ca.options[0])
+	strcat (ca.options, ",");
+      strcat (ca.options, argv[k]);
+    }
+  }
+  if (!ca.options[0])
+    strcpy (ca.options, "-");
+
+  N = 1 << ca.level;
+  lean_step = ca.lean;
+  fused_step = ca.fusedStep;
+  FUSED_RESIDUAL = ca.fused;
+#if !TREE
+  if (ca.refine) {
+    fprintf (ferr, "%s: refine needs a tree grid\n", argv[0]);
+    exit (1);
+  }
+#endif
+#if dimension == 3
+  WiFast = ca.WiFast;
+#else
+  if (ca.WiFast) {
+    fprintf (ferr, "%s: WiFast is only available in 3D\n", argv[0]);
+    exit (1);
+  }
+#endif
+#if dimension == 3 && TREE
+  ltsLevels = ca.lts;
+#else
+  if (ca.lts) {
+    fprintf (ferr, "%s: lts is only available on octrees\n", argv[0]);
+    exit (1);
+  }
+#endif
+#if TENSOR || SCALAR2D
+  if (ca.psiDiffusion || ca.betaBSD) {
+    fprintf (ferr, "%s: psiDiffusion and betaBSD need the scalar-3D solver\n",
+	     argv[0]);
+    exit (1);
+  }
+#else
+  psiDiffusion = ca.psiDiffusion;
+  betaBSD = ca.betaBSD;
+#endif
+#if FENE_P
+  L2 = 1e8;
+#endif
+}
+
+/**
+The solvent viscosity is constant, the polymer is set by its modulus
+and its relaxation time. The both-sides diffusion adds its artificial
+viscosity to *mu* before each viscous solve: with *betaBSD*, *mu* is
+thus a face field, reset to the solvent viscosity at every timestep
+(as done by [two-phaseVE.h](../src-local/two-phaseVE.h)). */
+
+void ca_properties (double mus, double mup, double lam)
+{
+  const face vector muc[] = {mus, mus, mus};
+  const scalar Gc[] = mup/lam, lamc[] = lam;
+  ca.mus = mus;
+  mu = muc;
+  Gp = Gc;
+  lambda = lamc;
+}
+
+event defaults (i = 0)
+{
+  if (ca.betaBSD)
+    mu = new face vector;
+}
+
+event properties (i++)
+{
+  if (ca.betaBSD) {
+    face vector muv = mu;
+    foreach_face()
+      muv.x[] = fm.x[]*ca.mus;
+  }
+}
+
+/**
+*ca_refine()* refines the quarter of the domain next to the top
+boundary by *refine* levels. It is called by the *init* event of each
+case. */
+
+void ca_refine()
+{
+#if TREE
+  if (ca.refine)
+    refine (y > 0.75*L0 + Y0 && level < ca.level + ca.refine);
+#endif
+}
+
+void ca_error (double e)
+{
+  ca.sum2 += sq(e), ca.n++;
+  if (fabs(e) > ca.emax)
+    ca.emax = fabs(e);
+}
+
+/**
+With *lean*, the constitutive solver must build the face velocity in
+its acceleration event at every timestep (see *uf_fusable()* in
+[centered.h](../basilisk/src/navier-stokes/centered.h)). */
+
+void ca_report (const char * name)
+{
+  if (ca.lean && uf_fused < iter) {
+    fprintf (ferr, "%s: the face velocity was fused on %ld of %d timesteps\n",
+	     name, uf_fused, iter);
+    exit (1);
+  }
+  if (pid() > 0)
+    return;
+  FILE * fp = fopen ("costAccuracy.dat", "r");
+  bool header = (fp == NULL);
+  if (fp)
+    fclose (fp);
+  if ((fp = fopen ("costAccuracy.dat", "a")) == NULL) {
+    perror ("costAccuracy.dat");
+    exit (1);
+  }
+  if (header)
+    fputs ("# case variant dim level options cells steps cellsxsteps wall"
+	   " errL2 errLinf\n", fp);
+  fprintf (fp, "%s %s %d %d %s %ld %d %ld %g %g %g\n",
+	   name, VARIANT, dimension, ca.level, ca.options, grid->tn, iter,
+	   perf.tnc, perf.t, ca.n ? sqrt (ca.sum2/ca.n) : nodata, ca.emax);
+  fclose (fp);
+}
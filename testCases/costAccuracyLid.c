@@ -0,0 +1,125 @@
+/** Title: costAccuracyLid.c
+# Oldroyd-B lid-driven cavity: cost versus accuracy
+
+# Author: Vatsal Sanjay
+# vatsalsanjay@gmail.com
+# Physics of Fluids
+# Updated: Oct 18, 2026
+
+The case of [lid-oldroydb.c](../basilisk/src/test/lid-oldroydb.c)
+(Fattal \& Kupferman, 2005) for the solvers of `src-local` (see
+[costAccuracy.h](costAccuracy.h)): $\beta = 0.5$, $Wi = 1$ and the lid
+velocity
+$$
+u_{top} = 8 \left[ 1 + \tanh \left(8 (t - \frac{1}{2}) \right) \right] x^2 (1-x)^2
+$$
+The kinetic energy is compared every 0.05 time units with that of the
+reference run `lid-oldroydb.ref` ($64^2$, upstream
+[log-conform.h](../basilisk/src/log-conform.h)), interpolated linearly
+in time. The errors are relative to the maximum reference energy over
+the comparison window. In the 3D analogue (`-grid=octree`), the cavity
+is periodic along $z$ and the energy is per unit span.
+
+~~~bash
+qcc -O2 -disable-dimensions costAccuracyLid.c -o costAccuracyLid -lm
+./costAccuracyLid level=6 tmax=2
+~~~
+
+The reference is looked for in `../basilisk/src/test/`, unless given
+with `ref=FILE`.
+*/
+
+#include "navier-stokes/centered.h"
+#include "costAccuracy.h"
+
+#define DT_MAX 5e-4
+#define MU0 1.
+#define BETA 0.5
+#define MUP ((1. - BETA)*MU0)
+#define MUS (BETA*MU0)
+#define WI 1.
+#define uwall(x,t) (8.*(1. + tanh(8.*(t - 0.5)))*sq(x)*sq(1. - x))
+
+int nref = 0;
+double * tref = NULL, * eref = NULL, emax = 0.;
+
+int main (int argc, char const * argv[])
+{
+  ca.tmax = 2.;
+  ca.ref = "../basilisk/src/test/lid-oldroydb.ref";
+  ca_options (argc, argv);
+
+  FILE * fp = fopen (ca.ref, "r");
+  if (fp == NULL) {
+    perror (ca.ref);
+    exit (1);
+  }
+  double tr, er;
+  while (fscanf (fp, "%lf %lf", &tr, &er) == 2) {
+    tref = realloc (tref, (nref + 1)*sizeof(double));
+    eref = realloc (eref, (nref + 1)*sizeof(double));
+    tref[nref] = tr, eref[nref++] = er;
+  }
+  fclose (fp);
+  for (int k = 0; k < nref; k++)
+    if (tref[k] <= ca.tmax && eref[k] > emax)
+      emax = eref[k];
+#if dimension == 3
+  periodic (front);
+#endif
+  DT = DT_MAX;
+  stokes = true;
+  ca_properties (MUS, MUP, WI);
+  run();
+  free (tref), free (eref);
+}
+
+u.t[top]    = dirichlet(uwall(x,t));
+u.t[bottom] = dirichlet(0);
+u.t[left]   = dirichlet(0);
+u.t[right]  = dirichlet(0);
+#if dimension == 3
+u.r[top]    = dirichlet(0);
+u.r[bottom] = dirichlet(0);
+u.r[left]   = dirichlet(0);
+u.r[right]  = dirichlet(0);
+#endif
+
+event init (i = 0)
+{
+  ca_refine();
+  foreach()
+    u.x[] = 0.;
+}
+
+static double energy()
+{
+  double se = 0.;
+  foreach (reduction(+:se)) {
+    double ke = 0.;
+    foreach_dimension()
+      ke += sq(u.x[]);
+    se += ke/2.*dv();
+  }
+  return dimension == 3 ? se/L0 : se;
+}
+
+static double reference (double t)
+{
+  int k = 1;
+  while (k < nref - 1 && tref[k] < t)
+    k++;
+  return eref[k - 1] + (eref[k] - eref[k - 1])*
+    (t - tref[k - 1])/(tref[k] - tref[k - 1]);
+}
+
+event kinetic_energy (t += 0.05; t <= ca.tmax)
+{
+  if (t > 0.)
+    ca_error ((energy() - reference (t))/emax);
+}
+
+event report (t = end)
+{
+  ca_report ("lid");
+}
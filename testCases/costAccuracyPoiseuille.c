@@ -0,0 +1,117 @@
+/** Title: costAccuracyPoiseuille.c
+# Transient planar Poiseuille flow of an Oldroyd-B fluid: cost versus accuracy
+
+# Author: Vatsal Sanjay
+# vatsalsanjay@gmail.com
+# Physics of Fluids
+# Updated: Oct 18, 2026
+
+The case of [poiseuille-oldroydb.c](../basilisk/src/test/poiseuille-oldroydb.c)
+for the solvers of `src-local` (see [costAccuracy.h](costAccuracy.h)).
+The flow starts from rest under a unit pressure gradient, here a unit
+body force. The velocity on the axis, scaled with the mean steady
+velocity, is compared with the analytical solution of Waters \& King
+(1970) every 0.2 time units. The 3D analogue (`-grid=octree`) is
+periodic along $z$ and has the same solution.
+
+~~~bash
+qcc -O2 -disable-dimensions costAccuracyPoiseuille.c -o costAccuracyPoiseuille -lm
+./costAccuracyPoiseuille level=5 tmax=5
+~~~
+
+The grid is a uniform quadtree (or octree), so that the options of
+the solvers which need a tree are available, refined near the wall
+with *refine*.
+*/
+
+#include <complex.h>
+#include "navier-stokes/centered.h"
+#include "costAccuracy.h"
+
+#define DT_MAX 0.001
+#define MU0 1.
+#define BETA (1/9.)
+#define MUP ((1. - BETA)*MU0)
+#define MUS (BETA*MU0)
+#define LAM 1.
+#define UAVG (1./(3.*MU0))
+
+int main (int argc, char const * argv[])
+{
+  ca.tmax = 10.;
+  ca_options (argc, argv);
+  periodic (right);
+#if dimension == 3
+  periodic (front);
+#endif
+  DT = DT_MAX;
+  ca_properties (MUS, MUP, LAM);
+  run();
+}
+
+u.t[top] = dirichlet(0);
+u.t[bottom] = neumann(0);
+#if dimension == 3
+u.r[top] = dirichlet(0);
+u.r[bottom] = neumann(0);
+#endif
+
+/**
+The bottom boundary is the axis of the channel: the shear components
+of the stress and of the conformation tensor are antisymmetric. */
+
+event init (i = 0)
+{
+#if TENSOR
+  tau_p.x.y[bottom] = dirichlet(0.);
+  conform_p.x.y[bottom] = dirichlet(0.);
+#else
+  T12[bottom] = dirichlet(0.);
+  A12[bottom] = dirichlet(0.);
+#if dimension == 3
+  T23[bottom] = dirichlet(0.);
+  A23[bottom] = dirichlet(0.);
+#endif
+#endif
+  ca_refine();
+  foreach()
+    u.x[] = 0.;
+}
+
+event acceleration (i++)
+{
+  face vector av = a;
+  foreach_face(x)
+    av.x[] += 1.;
+}
+
+double analytical (double Y, double T, int KF)
+{
+  double E = LAM*MU0;
+  double U = 0.;
+  for (int k = 1; k <= KF; k++) {
+    double n = (2*k - 1)*M_PI;
+    double alpha = 1. + 0.25*BETA*E*sq(n);
+    complex double beta = csqrt(sq(alpha) - E*sq(n));
+    double gamma = 1. - 0.25*(2. - BETA)*E*sq(n);
+    double G = creal(ccosh(0.5*beta*T) + gamma/beta*csinh(0.5*beta*T));
+    U += 1./n/sq(n)*sin(0.5*(1. + Y)*n)*exp(-0.5*alpha*T)*G;
+  }
+  return 1.5*(1. - sq(Y)) - 48.*U;
+}
+
+event uaxis (t += 0.2; t <= ca.tmax)
+{
+#if dimension == 3
+  double uaxis = interpolate (u.x, 0.5, 0., 0.5);
+#else
+  double uaxis = interpolate (u.x, 0.5, 0.);
+#endif
+  if (t > 0.)
+    ca_error (uaxis/UAVG - analytical (0., t/LAM, 8));
+}
+
+event report (t = end)
+{
+  ca_report ("poiseuille");
+}
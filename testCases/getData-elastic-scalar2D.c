@@ -6,6 +6,7 @@
 
 #include "utils.h"
 #include "output.h"
+#include "../src-local/snapshot-store.h"
 
 scalar f[];
 vector u[];
@@ -33,7 +34,8 @@ int main(int a, char const *arguments[])
   /*
   Actual run and codes!
   */
-  restore (file = filename);
+  restore_store (file = filename,
+                list = {f, u.x, u.y, A11, A12, A22, conform_qq});
 
   foreach() {
     double D11 = (u.y[0,1] - u.y[0,-1])/(2*Delta);
@@ -7,6 +7,7 @@
 #include "utils.h"
 #include "output.h"
 #include "fractions.h"
+#include "../src-local/snapshot-store.h"
 
 scalar f[];
 char filename[80];
@@ -14,7 +15,10 @@ char filename[80];
 int main(int a, char const *arguments[]){
   sprintf(filename, "%s", arguments[1]);
 
-  restore (file = filename);
+  // only the chunks of f are read from the snapshot store; an optional
+  // second argument caps the level, for previews
+  restore_store (file = filename, list = {f},
+                 maxlevel = a > 2 ? atoi(arguments[2]) : -1);
 
   FILE * fp = ferr;
   output_facets(f,fp);
@@ -30,6 +30,9 @@
 
 #include "navier-stokes/conserving.h"
 #include "tension.h"
+#include "../src-local/snapshot-store.h"
+#include "../src-local/neck-tracker.h"
+#include "../src-local/async-diagnostics.h"
 
 #define tsnap (1e-2)
 
@@ -82,6 +85,7 @@ int main(int argc, char const *argv[]) {
   lambda1 = De, lambda2 = 0.;
   G1 = Ec, G2 = 0.;
   f.sigma = 1.0;
+  heights_band = true; // heights only near the interface
 
   run();
 
@@ -99,6 +103,7 @@ event init (t = 0) {
 */
 event adapt(i++){
   scalar KAPPA[];
+  KAPPA.single = true; // refinement criterion only: exchanged in single precision
   curvature(f, KAPPA);
   adapt_wavelet ((scalar *){f, u.x, u.y, KAPPA},
       (double[]){fErr, VelErr, VelErr, KErr},
@@ -111,7 +116,23 @@ event adapt(i++){
 event writingFiles (t = 0; t += tsnap; t <= tmax) {
   dump (file = dumpFile);
   sprintf (nameOut, "intermediate/snapshot-%5.4f", t);
-  dump(file=nameOut);
+  // chunked snapshots: only the chunks which changed are written
+  dump_store (file = nameOut);
+}
+
+/**
+## Neck tracking
+
+The neck radius, the filament length and the axial polymer stress and
+stretch at the neck are written every timestep to neck.dat, so that
+the snapshots above are only needed at a coarse cadence.
+*/
+event neckTracking (i++) {
+#if VANILLA
+  neck_tracker (f, (scalar *){tau_p.x.x, conform_p.x.x}, "neck.dat");
+#else
+  neck_tracker (f, (scalar *){T11, A11}, "neck.dat");
+#endif
 }
 
 /**
@@ -124,7 +145,32 @@ event end (t = end) {
 
 /**
 ## Log writing
+The reductions are done in the event; the log file and the terminal
+are written by the helper thread of
+[async-diagnostics.h](../src-local/async-diagnostics.h), while the
+next timestep runs.
 */
+static void logLine (const AsyncSnapshot * s) {
+  const double * v = s->data;
+  FILE * fp = fopen(logFile, s->i == 0 ? "w" : "a");
+  if (fp == NULL) {
+    fprintf(ferr, "Error opening log file\n");
+    return;
+  }
+
+  if (s->i == 0) {
+    fprintf(ferr, "Level %d, Oh %2.1e, Oha %2.1e, De %2.1e, Ec %2.1e\n", MAXlevel, Oh, Oha, De, Ec);
+    fprintf(ferr, "i dt t ke ymin\n");
+    fprintf(fp, "Level %d, Oh %2.1e, Oha %2.1e, De %2.1e, Ec %2.1e\n", MAXlevel, Oh, Oha, De, Ec);
+    fprintf(fp, "i dt t ke ymin\n");
+  }
+
+  fprintf(fp, "%d %g %g %g %g\n", s->i, s->dt, s->t, v[0], v[1]);
+  fprintf(ferr, "%d %g %g %g %g\n", s->i, s->dt, s->t, v[0], v[1]);
+
+  fclose(fp);
+}
+
 event logWriting (i++) {
 
   double ke = 0.;
@@ -132,31 +178,14 @@ event logWriting (i++) {
     ke += (2*pi*y)*(0.5*rho(f[])*(sq(u.x[]) + sq(u.y[])+ sq(u.z[])))*sq(Delta);
   }
 
-  static FILE * fp;
-  if (pid() == 0) {
-    const char* mode = (i == 0) ? "w" : "a";
-    fp = fopen(logFile, mode);
-    if (fp == NULL) {
-      fprintf(ferr, "Error opening log file\n");
-      return 1;
-    }
+  // collective operations: must be called by all processes
+  scalar pos[];
+  position (f, pos, {0,1,0});
+  double ymin = statsf(pos).min;
 
-    scalar pos[];
-    position (f, pos, {0,1,0});
-    double ymin = statsf(pos).min;
-
-    if (i == 0) {
-      fprintf(ferr, "Level %d, Oh %2.1e, Oha %2.1e, De %2.1e, Ec %2.1e\n", MAXlevel, Oh, Oha, De, Ec);
-      fprintf(ferr, "i dt t ke ymin\n");
-      fprintf(fp, "Level %d, Oh %2.1e, Oha %2.1e, De %2.1e, Ec %2.1e\n", MAXlevel, Oh, Oha, De, Ec);
-      fprintf(fp, "i dt t ke ymin\n");
-    }
-
-    fprintf(fp, "%d %g %g %g %g\n", i, dt, t, ke, ymin);
-    fprintf(ferr, "%d %g %g %g %g\n", i, dt, t, ke, ymin);
-
-    fflush(fp);
-    fclose(fp);
+  if (pid() == 0) {
+    double values[2] = {ke, ymin};
+    async_diagnostic (logLine, data = values, size = sizeof(values));
   }
 
   assert(ke > -1e-10);
@@ -167,9 +196,10 @@ event logWriting (i++) {
         "The kinetic energy blew up. Stopping simulation\n" : 
         "kinetic energy too small now! Stopping!\n";
       
+      async_wait();
       fprintf(ferr, "%s", message);
       
-      fp = fopen("log", "a");
+      FILE * fp = fopen("log", "a");
       fprintf(fp, "%s", message);
       fflush(fp);
       fclose(fp);